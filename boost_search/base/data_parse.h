@@ -6,8 +6,21 @@
 #include <fstream>
 #include <filesystem>
 #include <vector>
+#include <map>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
 #include <boost_search/base/log.h>
 #include <boost_search/base/public_data.h>
+#include <boost_search/base/manifest.h>
 #include <boost_search/utils/file_op.h>
 
 namespace bs_data_parse
@@ -19,7 +32,438 @@ namespace bs_data_parse
     // HTML文件后缀
     const std::string g_html_extension = ".html";
     // 用于拼接的官网URL
-    const std::string g_url_to_concat = "https://www.boost.org/doc/libs/1_78_0/doc/html";
+    using bs_public_data::g_url_to_concat;
+
+    // 每个解析线程允许领先写出位置的文件数，用于限制流水线中驻留的文档数量
+    const size_t g_pending_per_thread = 16;
+
+    // 深度优先遍历数据源目录，对每个HTML文件调用func，顺序与recursive_directory_iterator一致
+    // 使用error_code版本的接口，不抛出异常：无法打开的子目录记录日志后跳过，不影响其他目录；遍历过程中出现过错误时返回false
+    // 不使用recursive_directory_iterator是因为它在进入子目录失败时会直接变为结束迭代器，后面的条目全部丢失
+    template <class Func>
+    bool forEachHtmlFile(Func &&func)
+    {
+        bool complete = true;
+        std::error_code ec;
+        std::vector<std::filesystem::directory_iterator> dirs;
+        dirs.emplace_back(g_datasource_path, ec);
+        if (ec)
+        {
+            LOG(Level::Warning, "打开目录：{}失败：{}", g_datasource_path.string(), ec.message());
+            return false;
+        }
+
+        const std::filesystem::directory_iterator end;
+        while (!dirs.empty())
+        {
+            if (dirs.back() == end)
+            {
+                dirs.pop_back();
+                continue;
+            }
+
+            std::filesystem::directory_entry entry = *dirs.back();
+            dirs.back().increment(ec);
+            if (ec)
+            {
+                // 当前目录剩余的条目无法读取
+                LOG(Level::Warning, "读取目录：{}出错：{}", entry.path().parent_path().string(), ec.message());
+                complete = false;
+                dirs.pop_back();
+                ec.clear();
+            }
+
+            // 与recursive_directory_iterator默认行为一致，不进入符号链接指向的目录
+            std::error_code fec;
+            if (entry.is_directory(fec) && !entry.is_symlink(fec))
+            {
+                std::filesystem::directory_iterator sub(entry.path(), ec);
+                if (ec)
+                {
+                    LOG(Level::Warning, "打开目录：{}失败：{}，跳过该目录", entry.path().string(), ec.message());
+                    complete = false;
+                    ec.clear();
+                    continue;
+                }
+                dirs.push_back(std::move(sub));
+            }
+            else if (entry.is_regular_file(fec) && entry.path().extension() == g_html_extension)
+                func(entry);
+
+            if (fec)
+            {
+                LOG(Level::Warning, "获取文件：{}状态失败：{}", entry.path().string(), fec.message());
+                complete = false;
+            }
+        }
+        return complete;
+    }
+
+    // 有界阻塞队列，队列满时生产者阻塞，关闭后消费者取完剩余元素即退出
+    template <class T>
+    class BoundedQueue
+    {
+    public:
+        explicit BoundedQueue(size_t capacity)
+            : capacity_(capacity), closed_(false)
+        {
+        }
+
+        bool push(T value)
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            not_full_.wait(lock, [&]()
+                           { return queue_.size() < capacity_ || closed_; });
+            if (closed_)
+                return false;
+            queue_.push_back(std::move(value));
+            not_empty_.notify_one();
+            return true;
+        }
+
+        bool pop(T &out)
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            not_empty_.wait(lock, [&]()
+                            { return !queue_.empty() || closed_; });
+            if (queue_.empty())
+                return false;
+            out = std::move(queue_.front());
+            queue_.pop_front();
+            not_full_.notify_one();
+            return true;
+        }
+
+        void close()
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            closed_ = true;
+            not_full_.notify_all();
+            not_empty_.notify_all();
+        }
+
+    private:
+        size_t capacity_;
+        bool closed_;
+        std::deque<T> queue_;
+        std::mutex mtx_;
+        std::condition_variable not_full_;
+        std::condition_variable not_empty_;
+    };
+
+    // 解析线程的输出：文本文件记录和对应的清单信息
+    struct ParsedFile
+    {
+        std::string record; // 为空表示该文件解析失败
+        bs_manifest::ManifestEntry entry;
+    };
+
+    // 有序写出，按照文件遍历顺序写入结果，保证输出与串行解析一致
+    class OrderedWriter
+    {
+    public:
+        OrderedWriter(std::ostream &out, size_t window)
+            : out_(out), window_(window), next_(0), total_(0), walk_done_(false), written_(0)
+        {
+        }
+
+        // 提交第seq个文件的解析结果
+        // 领先写出位置过多时阻塞，限制驻留内存
+        void submit(uint64_t seq, ParsedFile file)
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            space_.wait(lock, [&]()
+                        { return seq < next_ + window_; });
+            pending_.emplace(seq, std::move(file));
+            ready_.notify_one();
+        }
+
+        // 目录遍历结束，设置文件总数
+        void finishWalk(uint64_t total)
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            total_ = total;
+            walk_done_ = true;
+            ready_.notify_one();
+        }
+
+        // 持续写出直到所有文件处理完毕，返回写出的记录数
+        // 按照写出顺序为文档分配ID并记录到清单中
+        uint64_t run(bs_manifest::Manifest *manifest)
+        {
+            while (true)
+            {
+                ParsedFile file;
+                {
+                    std::unique_lock<std::mutex> lock(mtx_);
+                    ready_.wait(lock, [&]()
+                                { return pending_.count(next_) || (walk_done_ && next_ == total_); });
+                    if (walk_done_ && next_ == total_)
+                        return written_;
+                    auto pos = pending_.find(next_);
+                    file = std::move(pos->second);
+                    pending_.erase(pos);
+                    next_++;
+                    space_.notify_all();
+                }
+
+                // 写文件时不持有锁
+                if (!file.record.empty())
+                {
+                    out_.write(file.record.data(), file.record.size());
+                    file.entry.doc_id = manifest->allocateDocId();
+                    manifest->getEntries()[file.entry.path] = std::move(file.entry);
+                    written_++;
+                }
+            }
+        }
+
+    private:
+        std::ostream &out_;
+        size_t window_;                            // 允许领先写出位置的记录数
+        uint64_t next_;                            // 下一个需要写出的序号
+        uint64_t total_;                           // 文件总数
+        bool walk_done_;                           // 目录遍历是否结束
+        uint64_t written_;                         // 已经写出的记录数
+        std::map<uint64_t, ParsedFile> pending_;   // 已经解析但还不能写出的记录
+        std::mutex mtx_;
+        std::condition_variable ready_;
+        std::condition_variable space_;
+    };
+
+    // 常见的HTML命名实体
+    struct HtmlEntity
+    {
+        const char *name;
+        size_t len;
+        char ch;
+    };
+
+    const HtmlEntity g_html_entities[] = {
+        {"&amp;", 5, '&'},
+        {"&lt;", 4, '<'},
+        {"&gt;", 4, '>'},
+        {"&quot;", 6, '"'},
+        {"&apos;", 6, '\''},
+        {"&nbsp;", 6, ' '}};
+
+#if defined(__SSSE3__)
+    // 去标签时每次处理的字节数
+    const size_t g_strip_chunk = 64;
+
+    // 64字节数据块中'<'、'>'和'\n'的位置掩码，第i位对应第i个字节
+    struct ChunkMasks
+    {
+        uint64_t lt;
+        uint64_t gt;
+        uint64_t nl;
+    };
+
+    // 计算p开始的64字节的字符掩码，支持AVX2时每次比较32字节，否则每次比较16字节
+    inline ChunkMasks scanChunk(const char *p)
+    {
+        ChunkMasks m;
+#if defined(__AVX2__)
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32));
+        auto match = [&](char c) -> uint64_t
+        {
+            __m256i x = _mm256_set1_epi8(c);
+            uint64_t l = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, x)));
+            uint64_t h = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, x)));
+            return l | (h << 32);
+        };
+        m.lt = match('<');
+        m.gt = match('>');
+        m.nl = match('\n');
+#else
+        __m128i v[4];
+        for (int i = 0; i < 4; i++)
+            v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * i));
+        auto match = [&](char c) -> uint64_t
+        {
+            __m128i x = _mm_set1_epi8(c);
+            uint64_t r = 0;
+            for (int i = 0; i < 4; i++)
+                r |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v[i], x)))) << (16 * i);
+            return r;
+        };
+        m.lt = match('<');
+        m.gt = match('>');
+        m.nl = match('\n');
+#endif
+        return m;
+    }
+
+    // 计算处理完每个字节后是否处于标签状态
+    // 状态只取决于最近一个尖括号：'<'之后为标签，'>'之后为文本，没有尖括号时沿用上一个数据块的状态
+    inline uint64_t labelMask(const ChunkMasks &m, bool in_label)
+    {
+        uint64_t label = in_label ? ~0ULL : 0;
+        uint64_t brackets = m.lt | m.gt;
+        while (brackets)
+        {
+            int pos = __builtin_ctzll(brackets);
+            uint64_t from = ~0ULL << pos;
+            uint64_t fill = ((m.lt >> pos) & 1) ? from : 0;
+            label = (label & ~from) | fill;
+            brackets &= brackets - 1;
+        }
+        return label;
+    }
+
+    // 8字节压缩的洗牌表，下标为保留字节的掩码
+    struct CompactTable
+    {
+        alignas(16) uint8_t shuffle[256][8];
+        uint8_t count[256];
+
+        CompactTable()
+        {
+            for (int mask = 0; mask < 256; mask++)
+            {
+                int k = 0;
+                for (int i = 0; i < 8; i++)
+                {
+                    if (mask & (1 << i))
+                        shuffle[mask][k++] = static_cast<uint8_t>(i);
+                }
+                count[mask] = static_cast<uint8_t>(k);
+                for (; k < 8; k++)
+                    shuffle[mask][k] = 0x80;
+            }
+        }
+    };
+
+    inline const CompactTable &getCompactTable()
+    {
+        static const CompactTable table;
+        return table;
+    }
+
+    // 将p开始的64字节中keep对应的字节按顺序写入dst，换行替换为空格，返回写入的字节数
+    // 每次按8字节整段写入，调用者需要保证dst之后至少有8字节空间
+    inline size_t compactChunk(const char *p, uint64_t keep, char *dst)
+    {
+        char *start = dst;
+        const CompactTable &table = getCompactTable();
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i space = _mm_set1_epi8(' ');
+        for (int g = 0; g < 8; g++)
+        {
+            unsigned mask = static_cast<unsigned>((keep >> (8 * g)) & 0xFF);
+            __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + 8 * g));
+            __m128i is_nl = _mm_cmpeq_epi8(v, newline);
+            v = _mm_or_si128(_mm_andnot_si128(is_nl, v), _mm_and_si128(is_nl, space));
+            v = _mm_shuffle_epi8(v, _mm_loadl_epi64(reinterpret_cast<const __m128i *>(table.shuffle[mask])));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(dst), v);
+            dst += table.count[mask];
+        }
+        return dst - start;
+    }
+#endif
+
+    // 将码点按照UTF-8编码写入dst
+    inline void writeUtf8(char *&dst, uint32_t cp)
+    {
+        if (cp < 0x80)
+            *dst++ = static_cast<char>(cp);
+        else if (cp < 0x800)
+        {
+            *dst++ = static_cast<char>(0xC0 | (cp >> 6));
+            *dst++ = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000)
+        {
+            *dst++ = static_cast<char>(0xE0 | (cp >> 12));
+            *dst++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            *dst++ = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else
+        {
+            *dst++ = static_cast<char>(0xF0 | (cp >> 18));
+            *dst++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            *dst++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            *dst++ = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    // 解码p处以'&'开头的实体，成功时将结果写入dst并返回实体长度，无法识别时返回0
+    // 解码结果总是比实体本身短，因此可以原地解码
+    inline size_t decodeHtmlEntity(const char *p, const char *end, char *&dst)
+    {
+        size_t remain = end - p;
+        for (const auto &e : g_html_entities)
+        {
+            if (remain >= e.len && std::memcmp(p, e.name, e.len) == 0)
+            {
+                *dst++ = e.ch;
+                return e.len;
+            }
+        }
+
+        // 数字实体：&#十进制; 或者 &#x十六进制;
+        if (remain < 4 || p[1] != '#')
+            return 0;
+        size_t i = 2;
+        bool hex = (p[i] == 'x' || p[i] == 'X');
+        if (hex)
+            i++;
+        uint32_t cp = 0;
+        size_t digits = 0;
+        // 最多读取7位数字，超出Unicode范围的不做处理
+        for (; i < remain && digits < 7; i++, digits++)
+        {
+            char c = p[i];
+            if (c >= '0' && c <= '9')
+                cp = cp * (hex ? 16 : 10) + (c - '0');
+            else if (hex && c >= 'a' && c <= 'f')
+                cp = cp * 16 + (c - 'a' + 10);
+            else if (hex && c >= 'A' && c <= 'F')
+                cp = cp * 16 + (c - 'A' + 10);
+            else
+                break;
+        }
+        // 代理区码点不是合法的字符，编码后是无效的UTF-8，与超出范围的码点一样保留原文
+        if (digits == 0 || i >= remain || p[i] != ';' || cp == 0 || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+            return 0;
+
+        // 控制字符会破坏文本文件的分隔符，统一替换为空格
+        if (cp < 0x20)
+            cp = ' ';
+        writeUtf8(dst, cp);
+        return i + 1;
+    }
+
+    // 原地解码[begin, end)中的实体，返回解码后的结束位置
+    inline char *decodeHtmlEntities(char *begin, char *end)
+    {
+        char *amp = static_cast<char *>(std::memchr(begin, '&', end - begin));
+        if (!amp)
+            return end;
+
+        char *dst = amp;
+        const char *p = amp;
+        while (p < end)
+        {
+            size_t n = decodeHtmlEntity(p, end, dst);
+            if (n == 0)
+            {
+                *dst++ = '&';
+                n = 1;
+            }
+            p += n;
+
+            // 下一个实体之前的文本整段前移
+            const char *next = static_cast<const char *>(std::memchr(p, '&', end - p));
+            if (!next)
+                next = end;
+            std::memmove(dst, p, next - p);
+            dst += next - p;
+            p = next;
+        }
+        return dst;
+    }
 
     // 内容状态
     enum ContentStatus
@@ -41,20 +485,9 @@ namespace bs_data_parse
                 return false;
             }
 
-            // 递归目录结束位置，相当于空指针nullptr
-            for (const auto &entry : std::filesystem::recursive_directory_iterator(g_datasource_path))
-            {
-                // 1. 不是普通文件就是目录，继续遍历
-                if (!std::filesystem::is_regular_file(entry))
-                    continue;
-
-                // 2. 是普通文件，但是不是HTML文件，继续遍历
-                if (entry.path().extension() != g_html_extension)
-                    continue;
-
-                // 3. 是普通文件并且是HTML文件，插入结果
-                sources_.push_back(std::move(entry.path()));
-            }
+            // 只收集普通的HTML文件，目录和其他文件跳过
+            forEachHtmlFile([&](const std::filesystem::directory_entry &entry)
+                            { sources_.push_back(entry.path()); });
 
             // 空结果返回false
             return !sources_.empty();
@@ -88,21 +521,60 @@ namespace bs_data_parse
             if (end == std::string::npos || start > end)
                 return false;
 
-            // 截取出其中的内容，左闭右开
+            // 截取出其中的内容，左闭右开，与正文一样解码实体
             *title = in.substr(start + std::string("<title>").size(), end - (start + std::string("<title>").size()));
+            if (!title->empty())
+            {
+                char *begin = &(*title)[0];
+                title->resize(decodeHtmlEntities(begin, begin + title->size()) - begin);
+            }
 
             return true;
         }
 
         // 读取HTML文件内容
+        // 1. 支持SSSE3时每次处理64字节，根据尖括号位置计算标签区域，文本字节压缩写入，换行替换为空格
+        // 2. 去除标签后再原地解码常见实体，实体解码出的尖括号不会被当作标签
         bool getContentFromHtml(std::string &out, std::string *body)
         {
+            const char *p = out.data();
+            const char *end = p + out.size();
+            // 正文不会超过源文件大小，先按照源文件大小分配空间，结束后再截断到实际长度
+            size_t old_size = body->size();
+            // 额外的空间用于整段写入时越界的部分
+            body->resize(old_size + out.size() + 8);
+            char *begin = &(*body)[0] + old_size;
+            char *dst = begin;
+
             // 默认状态为标签
             ContentStatus cs = ContentStatus::Label;
+#if defined(__SSSE3__)
+            while (static_cast<size_t>(end - p) >= g_strip_chunk)
+            {
+                ChunkMasks m = scanChunk(p);
+                bool in_label = (cs == ContentStatus::Label);
+                uint64_t label = labelMask(m, in_label);
+                // 字节i之前的状态为文本且字节i不是'<'时保留
+                uint64_t label_before = (label << 1) | static_cast<uint64_t>(in_label);
+                uint64_t keep = ~label_before & ~m.lt;
+
+                if (keep == ~0ULL && m.nl == 0)
+                {
+                    std::memcpy(dst, p, g_strip_chunk);
+                    dst += g_strip_chunk;
+                }
+                else if (keep)
+                    dst += compactChunk(p, keep, dst);
+
+                cs = (label >> 63) ? ContentStatus::Label : ContentStatus::OrdinaryContent;
+                p += g_strip_chunk;
+            }
+#endif
 
-            // 注意，因为文档没有中文，直接用char没有问题
-            for (char ch : out)
+            // 剩余不足64字节的部分（不支持SSSE3时为全部内容）逐字节处理
+            for (; p < end; p++)
             {
+                char ch = *p;
                 switch (cs)
                 {
                 // 读取到右尖括号且状态为标签说明接下来为文本内容
@@ -115,18 +587,15 @@ namespace bs_data_parse
                     if (ch == '<')
                         cs = ContentStatus::Label; // 切换状态
                     else
-                    {
-                        if (ch == '\n')
-                            *body += ' ';
-                        else
-                            *body += ch;
-                    }
+                        *dst++ = (ch == '\n') ? ' ' : ch;
                     break;
                 default:
                     break;
                 }
             }
 
+            dst = decodeHtmlEntities(begin, dst);
+            body->resize(old_size + (dst - begin));
             return true;
         }
 
@@ -158,46 +627,349 @@ namespace bs_data_parse
 
             for (const auto &path : sources_)
             {
-                std::string out; // 存储HTML文件内容
                 struct bs_public_data::ResultData rd;
-                // 1. 读取文件
-                if (!readHtmlFile(path, out))
-                {
-                    LOG(Level::Warning, "打开文件：{}失败", path.string());
-                    // 读取当前文件失败时继续读取后面的文件
+                // 读取当前文件失败时继续读取后面的文件
+                if (!parseHtmlFile(path, &rd))
                     continue;
+
+                results_.push_back(std::move(rd));
+            }
+
+            return true;
+        }
+
+        // 解析单个HTML文件
+        bool parseHtmlFile(const std::filesystem::path &path, bs_public_data::ResultData *rd)
+        {
+            std::string out; // 存储HTML文件内容
+            // 1. 读取文件
+            if (!readHtmlFile(path, out))
+            {
+                LOG(Level::Warning, "打开文件：{}失败", path.string());
+                return false;
+            }
+
+            return parseHtmlContent(path, out, rd);
+        }
+
+        // 解析已经读取的HTML文件内容
+        bool parseHtmlContent(const std::filesystem::path &path, std::string &out, bs_public_data::ResultData *rd)
+        {
+            // 2. 获取标题
+            if (!getTitleFromHtml(out, &rd->title))
+            {
+                LOG(Level::Warning, "获取文件标题失败");
+                return false;
+            }
+            // 标题中的换行会破坏文本文件的行结构
+            std::replace(rd->title.begin(), rd->title.end(), '\n', ' ');
+
+            // 3. 读取文件内容
+            if (!getContentFromHtml(out, &rd->body))
+            {
+                LOG(Level::Warning, "获取文件内容失败");
+                return false;
+            }
+
+            // 4. 构建URL
+            if (!constructHtmlUrl(path, &rd->url))
+            {
+                LOG(Level::Warning, "构建URL失败");
+                return false;
+            }
+
+            return true;
+        }
+
+        // 读取并解析HTML文件，同时记录文件信息，文件解析失败时返回false
+        bool parseHtmlFileWithEntry(const std::filesystem::path &path, ParsedFile *file)
+        {
+            std::string out;
+            if (!readHtmlFile(path, out))
+            {
+                LOG(Level::Warning, "打开文件：{}失败", path.string());
+                return false;
+            }
+
+            bs_manifest::ManifestEntry &e = file->entry;
+            e.path = path.string();
+            e.mtime = bs_manifest::getFileMtime(path);
+            e.size = out.size();
+            e.hash = bs_manifest::hashContent(out);
+
+            bs_public_data::ResultData rd;
+            if (!parseHtmlContent(path, out, &rd))
+                return false;
+
+            appendRecord(file->record, rd);
+            return true;
+        }
+
+        // 将结构体字段按照文本文件格式追加到out中
+        static void appendRecord(std::string &out, const bs_public_data::ResultData &rd)
+        {
+            out += rd.title;
+            out += bs_public_data::g_rd_sep;
+            out += rd.body;
+            out += bs_public_data::g_rd_sep;
+            out += rd.url;
+            out += bs_public_data::g_html_sep;
+        }
+
+        // 流式并行解析：目录遍历、多线程解析和有序写出同时进行
+        // 与getHtmlSourceFiles+readInfoFromHtml+writeToRawFile的结果一致，但不在内存中保存全部文档
+        bool parseAndWriteStreaming(size_t thread_num = std::thread::hardware_concurrency())
+        {
+            if (!std::filesystem::exists(g_datasource_path))
+            {
+                LOG(Level::Warning, "不存在指定路径");
+                return false;
+            }
+
+            // 先删除旧的清单再重写文本文件，中途失败时下一次增量解析退化为全量解析
+            std::filesystem::path manifest_path = bs_manifest::getManifestPath(bs_public_data::g_rawfile_path);
+            std::error_code ec;
+            std::filesystem::remove(manifest_path, ec);
+            if (ec)
+            {
+                LOG(Level::Warning, "删除解析清单失败：{}", ec.message());
+                return false;
+            }
+
+            std::ofstream f(bs_public_data::g_rawfile_path, std::ios::binary | std::ios::trunc);
+            if (!f.is_open())
+            {
+                LOG(Level::Warning, "打开文本文件失败");
+                return false;
+            }
+
+            if (thread_num == 0)
+                thread_num = 1;
+            size_t window = thread_num * g_pending_per_thread;
+            BoundedQueue<std::pair<uint64_t, std::filesystem::path>> paths(window);
+            OrderedWriter writer(f, window);
+            // 全量解析重写文本文件，生成新版本的清单
+            bs_manifest::Manifest manifest;
+            manifest.resetGeneration();
+
+            // 目录遍历线程
+            std::thread walker([&]()
+                               {
+                uint64_t seq = 0;
+                // 遍历出错时只跳过出错的条目，保证队列总能正常关闭
+                forEachHtmlFile([&](const std::filesystem::directory_entry &entry)
+                                { paths.push(std::make_pair(seq++, entry.path())); });
+                paths.close();
+                writer.finishWalk(seq); });
+
+            // 解析线程
+            std::vector<std::thread> parsers;
+            for (size_t i = 0; i < thread_num; i++)
+            {
+                parsers.emplace_back([&]()
+                                     {
+                    std::pair<uint64_t, std::filesystem::path> item;
+                    while (paths.pop(item))
+                    {
+                        ParsedFile file;
+                        if (!parseHtmlFileWithEntry(item.second, &file))
+                            file.record.clear();
+                        writer.submit(item.first, std::move(file));
+                    } });
+            }
+
+            // 当前线程负责有序写出
+            uint64_t written = writer.run(&manifest);
+
+            walker.join();
+            for (auto &t : parsers)
+                t.join();
+
+            // 文本文件完整写入后再保存清单
+            uint64_t raw_size = static_cast<uint64_t>(f.tellp());
+            f.close();
+            if (!f)
+            {
+                LOG(Level::Warning, "写入文本文件失败");
+                return false;
+            }
+            manifest.setRawSize(raw_size);
+            if (!manifest.save(manifest_path))
+                return false;
+
+            LOG(Level::Info, "解析完成，共写入：{}个文件", written);
+            return written > 0;
+        }
+
+        // 增量解析：根据清单只处理新增、修改和删除的文件
+        // 1. 修改时间和大小都没有变化的文件直接跳过，变化的文件再比较内容哈希
+        // 2. 新增和内容变化的文件追加到文本文件末尾并分配新的文档ID，旧的文档ID从清单中移除
+        // 3. 删除的文件从清单中移除，索引根据清单将不在其中的文档标记为已删除
+        // 4. 变化的文件按批在thread_num个线程中并行解析，每批解析完成后按照遍历顺序串行写出
+        // 不存在清单时执行全量解析
+        bool parseIncremental(size_t thread_num = std::thread::hardware_concurrency())
+        {
+            std::filesystem::path manifest_path = bs_manifest::getManifestPath(bs_public_data::g_rawfile_path);
+            bs_manifest::Manifest manifest;
+            if (!manifest.load(manifest_path) || !std::filesystem::exists(bs_public_data::g_rawfile_path))
+            {
+                LOG(Level::Info, "不存在解析清单，执行全量解析");
+                return parseAndWriteStreaming(thread_num);
+            }
+
+            // 文本文件比清单记录的短说明被其他方式修改过，无法继续追加
+            // 比清单记录的长说明上一次追加后没有成功保存清单，截断多余的部分
+            std::error_code ec;
+            uint64_t raw_size = std::filesystem::file_size(bs_public_data::g_rawfile_path, ec);
+            if (ec || raw_size < manifest.getRawSize())
+            {
+                LOG(Level::Warning, "文本文件与解析清单不一致，执行全量解析");
+                return parseAndWriteStreaming(thread_num);
+            }
+            if (raw_size > manifest.getRawSize())
+            {
+                LOG(Level::Warning, "文本文件存在未记录到清单的追加内容：{}字节，截断", raw_size - manifest.getRawSize());
+                std::filesystem::resize_file(bs_public_data::g_rawfile_path, manifest.getRawSize(), ec);
+                if (ec)
+                {
+                    LOG(Level::Warning, "截断文本文件失败：{}，执行全量解析", ec.message());
+                    return parseAndWriteStreaming(thread_num);
                 }
+            }
+
+            if (!std::filesystem::exists(g_datasource_path))
+            {
+                LOG(Level::Warning, "不存在指定路径");
+                return false;
+            }
 
-                // 2. 获取标题
-                if (!getTitleFromHtml(out, &rd.title))
+            auto &entries = manifest.getEntries();
+            std::unordered_map<std::string, bool> seen;
+            std::vector<std::filesystem::path> changed;
+            bool complete = forEachHtmlFile([&](const std::filesystem::directory_entry &entry)
+                                            {
+                std::string key = entry.path().string();
+                seen[key] = true;
+                auto pos = entries.find(key);
+                std::error_code ec;
+                uintmax_t size = entry.file_size(ec);
+                if (!ec && pos != entries.end() && pos->second.mtime == bs_manifest::getFileMtime(entry.path()) && pos->second.size == size)
+                    return;
+                changed.push_back(entry.path()); });
+
+            // 清单中存在但是目录中已经不存在的文件
+            // 遍历不完整时无法区分文件是删除还是没有遍历到，保留这些文件
+            if (!complete)
+                LOG(Level::Warning, "目录遍历不完整，本次不处理已删除的文件");
+            size_t deleted = 0;
+            for (auto it = entries.begin(); it != entries.end();)
+            {
+                if (!complete || seen.count(it->first))
                 {
-                    LOG(Level::Warning, "获取文件标题失败");
+                    ++it;
                     continue;
                 }
+                it = entries.erase(it);
+                deleted++;
+            }
+
+            std::ofstream f(bs_public_data::g_rawfile_path, std::ios::binary | std::ios::app);
+            if (!f.is_open())
+            {
+                LOG(Level::Warning, "打开文本文件失败");
+                return false;
+            }
 
-                // 3. 读取文件内容
-                if (!getContentFromHtml(out, &rd.body))
+            if (thread_num == 0)
+                thread_num = 1;
+            size_t window = thread_num * g_pending_per_thread;
+            std::vector<ParsedFile> files;
+            std::vector<uint8_t> oks;
+            size_t added = 0, updated = 0, touched = 0;
+            uint64_t appended = 0;
+            for (size_t i = 0; i < changed.size(); i++)
+            {
+                // 每批最多window个文件，限制驻留内存
+                size_t slot = i % window;
+                if (slot == 0)
                 {
-                    LOG(Level::Warning, "获取文件内容失败");
+                    size_t n = std::min(window, changed.size() - i);
+                    files.assign(n, ParsedFile());
+                    oks.assign(n, 0);
+                    std::atomic<size_t> next(0);
+                    auto parse = [&]()
+                    {
+                        for (size_t k = next.fetch_add(1); k < n; k = next.fetch_add(1))
+                            oks[k] = parseHtmlFileWithEntry(changed[i + k], &files[k]);
+                    };
+                    std::vector<std::thread> parsers;
+                    for (size_t t = 1; t < std::min(thread_num, n); t++)
+                        parsers.emplace_back(parse);
+                    parse();
+                    for (auto &t : parsers)
+                        t.join();
+                }
+
+                const auto &path = changed[i];
+                ParsedFile &file = files[slot];
+                bool ok = oks[slot];
+                auto pos = entries.find(path.string());
+
+                // 只有修改时间变化而内容没有变化，只更新文件信息
+                if (pos != entries.end() && !file.entry.path.empty() && pos->second.hash == file.entry.hash)
+                {
+                    pos->second.mtime = file.entry.mtime;
+                    pos->second.size = file.entry.size;
+                    touched++;
                     continue;
                 }
 
-                // 4. 构建URL
-                if (!constructHtmlUrl(path, &rd.url))
+                bool existed = (pos != entries.end());
+                if (existed)
+                    entries.erase(pos);
+                if (!ok)
                 {
-                    LOG(Level::Warning, "构建URL失败");
+                    deleted += existed;
                     continue;
                 }
 
-                results_.push_back(std::move(rd));
+                f.write(file.record.data(), file.record.size());
+                appended += file.record.size();
+                file.entry.doc_id = manifest.allocateDocId();
+                entries[file.entry.path] = std::move(file.entry);
+                if (existed)
+                    updated++;
+                else
+                    added++;
             }
 
+            // 文本文件完整写入后再保存清单，任何一步失败都截断本次追加的内容，文本文件与磁盘上的旧清单保持一致
+            uint64_t old_raw_size = manifest.getRawSize();
+            f.close();
+            if (!f)
+            {
+                LOG(Level::Warning, "写入文本文件失败");
+                std::filesystem::resize_file(bs_public_data::g_rawfile_path, old_raw_size, ec);
+                return false;
+            }
+            manifest.setRawSize(old_raw_size + appended);
+            if (!manifest.save(manifest_path))
+            {
+                std::filesystem::resize_file(bs_public_data::g_rawfile_path, old_raw_size, ec);
+                return false;
+            }
+
+            LOG(Level::Info, "增量解析完成，新增：{}，修改：{}，删除：{}，仅更新时间：{}", added, updated, deleted, touched);
             return true;
         }
 
         // 将结构体字段写入文本文件中
+        // 串行接口不记录文件信息，删除旧的清单使下一次增量解析退化为全量解析
         bool writeToRawFile()
         {
+            std::error_code ec;
+            std::filesystem::remove(bs_manifest::getManifestPath(bs_public_data::g_rawfile_path), ec);
+
             // 以二进制形式打开文件
             std::fstream f(bs_public_data::g_rawfile_path);
 
@@ -211,12 +983,7 @@ namespace bs_data_parse
             for (auto &rd : results_)
             {
                 std::string temp;
-                temp += rd.title;
-                temp += bs_public_data::g_rd_sep;
-                temp += rd.body;
-                temp += bs_public_data::g_rd_sep;
-                temp += rd.url;
-                temp += bs_public_data::g_html_sep;
+                appendRecord(temp, rd);
 
                 f.write(temp.c_str(), temp.size());
             }
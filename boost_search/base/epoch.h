@@ -0,0 +1,137 @@
+#ifndef __bs_epoch_h__
+#define __bs_epoch_h__
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+
+namespace bs_epoch
+{
+    /**
+     * 基于纪元的内存回收，用于读多写少的共享数据（例如搜索索引）
+     * 1. 读者进入临界区时在自己的槽位中记录当前纪元，离开时清零，不需要加锁
+     * 2. 写者原子替换指针后推进纪元，等待所有仍处于旧纪元的读者离开后再释放旧数据
+     * 读者不会被写者阻塞，写者只在回收时等待
+     */
+
+    // 最多同时参与的读者线程数
+    const size_t max_reader_slots = 256;
+    // 等待读者离开时的轮询间隔
+    const auto synchronize_interval = std::chrono::milliseconds(1);
+
+    // 读者槽位，独占缓存行避免伪共享
+    struct alignas(64) ReaderSlot
+    {
+        std::atomic<bool> owned{false};    // 是否已经被线程占用
+        std::atomic<uint64_t> epoch{0};    // 为0表示不在临界区内
+    };
+
+    class EpochManager
+    {
+    public:
+        static EpochManager &instance()
+        {
+            static EpochManager manager;
+            return manager;
+        }
+
+        // 进入临界区，记录当前纪元
+        void enter()
+        {
+            ReaderSlot *slot = localSlot();
+            slot->epoch.store(global_epoch_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            // 保证槽位写入先于之后对共享指针的读取被写者观察到
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+
+        // 离开临界区
+        void leave()
+        {
+            localSlot()->epoch.store(0, std::memory_order_release);
+        }
+
+        // 推进纪元并等待此前进入临界区的读者全部离开
+        // 调用前需要已经将共享指针替换为新数据，返回后旧数据可以安全释放
+        void synchronize()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            uint64_t target = global_epoch_.fetch_add(1, std::memory_order_acq_rel) + 1;
+            for (auto &slot : slots_)
+            {
+                while (true)
+                {
+                    uint64_t e = slot.epoch.load(std::memory_order_acquire);
+                    if (e == 0 || e >= target)
+                        break;
+                    std::this_thread::sleep_for(synchronize_interval);
+                }
+            }
+        }
+
+    private:
+        EpochManager()
+            : global_epoch_(1)
+        {
+        }
+
+        // 线程第一次进入临界区时占用一个槽位，线程退出时归还
+        ReaderSlot *localSlot()
+        {
+            struct SlotHolder
+            {
+                ReaderSlot *slot = nullptr;
+                ~SlotHolder()
+                {
+                    if (slot)
+                    {
+                        slot->epoch.store(0, std::memory_order_release);
+                        slot->owned.store(false, std::memory_order_release);
+                    }
+                }
+            };
+            thread_local SlotHolder holder;
+            if (holder.slot)
+                return holder.slot;
+
+            for (auto &slot : slots_)
+            {
+                bool expected = false;
+                if (slot.owned.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+                {
+                    holder.slot = &slot;
+                    return holder.slot;
+                }
+            }
+
+            // 槽位耗尽时无法保护读者，属于配置错误
+            std::abort();
+        }
+
+    private:
+        std::atomic<uint64_t> global_epoch_;
+        ReaderSlot slots_[max_reader_slots];
+    };
+
+    // 读者临界区守卫，作用域内读取到的共享数据不会被释放，同一线程内不能嵌套使用
+    class EpochGuard
+    {
+    public:
+        EpochGuard()
+        {
+            EpochManager::instance().enter();
+        }
+
+        ~EpochGuard()
+        {
+            EpochManager::instance().leave();
+        }
+
+        EpochGuard(const EpochGuard &) = delete;
+        EpochGuard &operator=(const EpochGuard &) = delete;
+    };
+}
+
+#endif
@@ -11,6 +11,12 @@
     [2025-04-25 22:25:25] [info] [test.cc:18] hello world
     使用方式：
     LOG(level, format, args)
+
+    异步模式：
+    ENABLE_ASYNC_LOG(queue_size, policy)开启后日志由后台线程写出，I/O线程只负责入队
+    队列满时按照OverflowPolicy处理，默认覆盖最旧日志，保证终端或磁盘变慢时不会阻塞事件循环
+    SET_LOG_RATE_LIMIT(n)限制每个调用点每秒最多输出n条日志，被抑制的条数会在下一次输出时给出
+    编译时定义BS_LOG_ACTIVE_LEVEL可以直接去除低于该等级的日志代码，例如：-DBS_LOG_ACTIVE_LEVEL=1去除Debug日志
 */
 
 #ifndef __bs_log_h__
@@ -19,7 +25,11 @@
 #include <memory>
 #include <string>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
 #include "spdlog/spdlog.h"
+#include "spdlog/async.h"                    // 异步日志
 #include "spdlog/sinks/basic_file_sink.h"    // 文件日志
 #include "spdlog/sinks/stdout_color_sinks.h" // 控制台彩色日志
 
@@ -35,6 +45,54 @@ namespace bs_log_system
         Critical
     };
 
+    // 异步模式下队列已满时的处理策略
+    enum class OverflowPolicy
+    {
+        Block,         // 阻塞等待队列有空位
+        OverrunOldest  // 覆盖队列中最旧的日志，不阻塞调用线程
+    };
+
+    // 异步日志队列默认长度
+    const size_t default_async_queue_size = 8192;
+
+    // 调用点级别的限流器，每个日志调用点持有一个静态对象
+    class RateLimiter
+    {
+    public:
+        RateLimiter()
+            : window_(0), count_(0), dropped_(0)
+        {
+        }
+
+        // 判断当前秒内是否还允许输出，允许时通过suppressed带回此前被抑制的条数
+        bool allow(uint32_t limit, uint64_t &suppressed)
+        {
+            suppressed = 0;
+            if (limit == 0)
+                return true;
+
+            int64_t now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            int64_t start = window_.load(std::memory_order_relaxed);
+            // 进入新的一秒时重置计数，只允许一个线程完成重置
+            if (now != start && window_.compare_exchange_strong(start, now, std::memory_order_relaxed))
+                count_.store(0, std::memory_order_relaxed);
+
+            if (count_.fetch_add(1, std::memory_order_relaxed) < limit)
+            {
+                suppressed = dropped_.exchange(0, std::memory_order_relaxed);
+                return true;
+            }
+
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+    private:
+        std::atomic<int64_t> window_;   // 当前计数窗口（秒）
+        std::atomic<uint32_t> count_;   // 当前窗口内已输出条数
+        std::atomic<uint64_t> dropped_; // 尚未报告的被抑制条数
+    };
+
     class LogSystem
     {
     private:
@@ -49,6 +107,39 @@ namespace bs_log_system
             logger_ = spdlog::stdout_color_mt("console_log");
         }
 
+        // 根据当前模式创建日志对象，调用者需要持有mode_mtx_
+        // 其他线程可能同时通过getLogger读取指针，新对象创建完成后原子地替换，
+        // 正在使用旧对象的线程持有自己的引用，不受影响
+        void createLogger()
+        {
+            spdlog::drop_all(); // 清除上一次的指针
+            std::shared_ptr<spdlog::logger> logger;
+            if (!async_pool_)
+            {
+                if (to_file_)
+                    logger = spdlog::basic_logger_mt("file_log", filepath);
+                else
+                    logger = spdlog::stdout_color_mt("console_log");
+                std::atomic_store(&logger_, logger);
+                return;
+            }
+
+            spdlog::sink_ptr sink;
+            if (to_file_)
+                sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(filepath);
+            else
+                sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+
+            spdlog::async_overflow_policy policy = spdlog::async_overflow_policy::overrun_oldest;
+            if (policy_ == OverflowPolicy::Block)
+                policy = spdlog::async_overflow_policy::block;
+
+            logger = std::make_shared<spdlog::async_logger>(to_file_ ? "file_log" : "console_log", sink, async_pool_, policy);
+            // 应用全局等级和格式并注册
+            spdlog::initialize_logger(logger);
+            std::atomic_store(&logger_, logger);
+        }
+
         // 禁用拷贝构造和赋值
         LogSystem(const LogSystem &) = delete;
         LogSystem &operator=(const LogSystem &) = delete;
@@ -75,16 +166,41 @@ namespace bs_log_system
         void enableFileLog()
         {
             std::unique_lock<std::mutex> lock(mode_mtx_);
-            spdlog::drop_all(); // 清除上一次的指针
-            logger_ = spdlog::basic_logger_mt("file_log", filepath);
+            to_file_ = true;
+            createLogger();
         }
 
         // 启用控制台输出
         void enableConsoleLog()
         {
             std::unique_lock<std::mutex> lock(mode_mtx_);
-            spdlog::drop_all(); // 清除上一次的指针
-            logger_ = spdlog::stdout_color_mt("console_log");
+            to_file_ = false;
+            createLogger();
+        }
+
+        // 启用异步输出，保持当前的控制台或文件目标
+        // 日志格式化在调用线程完成，写出由单个后台线程负责
+        void enableAsyncLog(size_t queue_size = default_async_queue_size, OverflowPolicy policy = OverflowPolicy::OverrunOldest)
+        {
+            std::unique_lock<std::mutex> lock(mode_mtx_);
+            policy_ = policy;
+            // 异步日志对象只保存线程池的弱引用，旧的线程池保留到程序结束，
+            // 避免仍然持有旧日志对象的线程写日志时线程池已经销毁
+            if (async_pool_)
+                retired_pools_.push_back(async_pool_);
+            async_pool_ = std::make_shared<spdlog::details::thread_pool>(queue_size, 1);
+            createLogger();
+        }
+
+        // 设置每个调用点每秒允许输出的日志条数，0表示不限制，Error和Critical日志不受限制
+        void setRateLimit(uint32_t per_second)
+        {
+            rate_limit_.store(per_second, std::memory_order_relaxed);
+        }
+
+        uint32_t getRateLimit()
+        {
+            return rate_limit_.load(std::memory_order_relaxed);
         }
 
         // 设置日志等级
@@ -112,20 +228,30 @@ namespace bs_log_system
             }
         }
 
-        // 获取日志指针
+        // 获取日志指针，可以与切换输出模式并发调用
         std::shared_ptr<spdlog::logger> getLogger()
         {
-            return logger_;
+            return std::atomic_load(&logger_);
         }
 
     private:
         static std::shared_ptr<LogSystem> baseLog_;
-        // 控制台指针
+        // 控制台指针，只通过std::atomic_load/std::atomic_store访问
         std::shared_ptr<spdlog::logger> logger_;
         // 单例锁
         // static std::mutex single_mtx_;
         // 模式切换锁
         std::mutex mode_mtx_;
+        // 是否输出到文件
+        bool to_file_ = false;
+        // 异步模式后台线程池，为空表示同步模式
+        std::shared_ptr<spdlog::details::thread_pool> async_pool_;
+        // 被替换的异步线程池
+        std::vector<std::shared_ptr<spdlog::details::thread_pool>> retired_pools_;
+        // 异步队列溢出策略
+        OverflowPolicy policy_ = OverflowPolicy::OverrunOldest;
+        // 每个调用点每秒最多输出的日志条数
+        std::atomic<uint32_t> rate_limit_{0};
     };
 
     // std::mutex LogSystem::single_mtx_;
@@ -136,23 +262,65 @@ namespace bs_log_system
 
 #define ENABLE_FILE_LOG() ls->enableFileLog()
 #define ENABLE_CONSOLE_LOG() ls->enableConsoleLog()
+#define ENABLE_ASYNC_LOG(...) ls->enableAsyncLog(__VA_ARGS__)
+#define SET_LOG_RATE_LIMIT(n) ls->setRateLimit(n)
+
+// 编译期日志等级阈值，低于该等级的日志宏展开为空语句
+// 0-Debug 1-Info 2-Warning 3-Error 4-Critical
+#ifndef BS_LOG_ACTIVE_LEVEL
+#define BS_LOG_ACTIVE_LEVEL 0
+#endif
+
+// 日志输出实现：先按运行时等级过滤，再按调用点限流
+// Error及以上的日志不限流，避免突发时丢失错误
+#define BS_LOG_IMPL(lvl, format, ...)                                                                            \
+    do                                                                                                           \
+    {                                                                                                            \
+        auto bs_logger_ = bs_log_system::ls->getLogger();                                                        \
+        if (!bs_logger_->should_log(lvl))                                                                        \
+            break;                                                                                               \
+        static bs_log_system::RateLimiter bs_limiter_;                                                           \
+        uint64_t bs_suppressed_ = 0;                                                                             \
+        uint32_t bs_limit_ = (lvl) >= spdlog::level::err ? 0 : bs_log_system::ls->getRateLimit();               \
+        if (!bs_limiter_.allow(bs_limit_, bs_suppressed_))                                                       \
+            break;                                                                                               \
+        if (bs_suppressed_ > 0)                                                                                  \
+            bs_logger_->log(lvl, "[{}:{}] 已抑制{}条重复日志", __FILE__, __LINE__, bs_suppressed_);                \
+        bs_logger_->log(lvl, "[{}:{}] " format, __FILE__, __LINE__, ##__VA_ARGS__);                              \
+    } while (0)
+
+#define BS_LOG_NONE() \
+    do                \
+    {                 \
+    } while (0)
 
 // 日志宏定义，带有文件名和行号
 // ##运算符的主要作用是处理没有提供可变参数时的逗号问题
-#define LOG_DEBUG(format, ...) \
-    ls->getLogger()->debug("[{}:{}] " format, __FILE__, __LINE__, ##__VA_ARGS__)
+#if BS_LOG_ACTIVE_LEVEL <= 0
+#define LOG_DEBUG(format, ...) BS_LOG_IMPL(spdlog::level::debug, format, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(format, ...) BS_LOG_NONE()
+#endif
 
-#define LOG_INFO(format, ...) \
-    ls->getLogger()->info("[{}:{}] " format, __FILE__, __LINE__, ##__VA_ARGS__)
+#if BS_LOG_ACTIVE_LEVEL <= 1
+#define LOG_INFO(format, ...) BS_LOG_IMPL(spdlog::level::info, format, ##__VA_ARGS__)
+#else
+#define LOG_INFO(format, ...) BS_LOG_NONE()
+#endif
 
-#define LOG_WARN(format, ...) \
-    ls->getLogger()->warn("[{}:{}] " format, __FILE__, __LINE__, ##__VA_ARGS__)
+#if BS_LOG_ACTIVE_LEVEL <= 2
+#define LOG_WARN(format, ...) BS_LOG_IMPL(spdlog::level::warn, format, ##__VA_ARGS__)
+#else
+#define LOG_WARN(format, ...) BS_LOG_NONE()
+#endif
 
-#define LOG_ERROR(format, ...) \
-    ls->getLogger()->error("[{}:{}] " format, __FILE__, __LINE__, ##__VA_ARGS__)
+#if BS_LOG_ACTIVE_LEVEL <= 3
+#define LOG_ERROR(format, ...) BS_LOG_IMPL(spdlog::level::err, format, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(format, ...) BS_LOG_NONE()
+#endif
 
-#define LOG_CRITICAL(format, ...) \
-    ls->getLogger()->critical("[{}:{}] " format, __FILE__, __LINE__, ##__VA_ARGS__)
+#define LOG_CRITICAL(format, ...) BS_LOG_IMPL(spdlog::level::critical, format, ##__VA_ARGS__)
 
 // 通用日志宏，可以指定日志级别
 #define LOG(level, format, ...)              \
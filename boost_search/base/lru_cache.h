@@ -0,0 +1,92 @@
+#ifndef __bs_lru_cache_h__
+#define __bs_lru_cache_h__
+
+#include <list>
+#include <iterator>
+#include <unordered_map>
+#include <utility>
+#include <cstddef>
+
+namespace bs_lru_cache
+{
+    /**
+     * 容量固定的LRU缓存，不加锁，由使用者保证只在一个线程中访问（例如声明为thread_local）
+     * 链表头部是最近使用的元素，插入时超过容量淘汰链表尾部的元素
+     * get返回的指针在该元素被淘汰之前一直有效
+     */
+    template <class Key, class Value, class Hash = std::hash<Key>>
+    class LruCache
+    {
+        using item_t = std::pair<Key, Value>;
+        using iterator_t = typename std::list<item_t>::iterator;
+
+    public:
+        explicit LruCache(size_t capacity)
+            : capacity_(capacity == 0 ? 1 : capacity)
+        {
+            index_.reserve(capacity_);
+        }
+
+        LruCache(const LruCache &) = delete;
+        LruCache &operator=(const LruCache &) = delete;
+
+        // 查找并标记为最近使用，不存在时返回nullptr
+        Value *get(const Key &key)
+        {
+            auto pos = index_.find(key);
+            if (pos == index_.end())
+                return nullptr;
+            items_.splice(items_.begin(), items_, pos->second);
+            return &pos->second->second;
+        }
+
+        // 插入或者覆盖，返回缓存中的值
+        Value &put(const Key &key, Value value)
+        {
+            auto pos = index_.find(key);
+            if (pos != index_.end())
+            {
+                items_.splice(items_.begin(), items_, pos->second);
+                pos->second->second = std::move(value);
+                return pos->second->second;
+            }
+
+            if (items_.size() >= capacity_)
+            {
+                // 复用被淘汰的节点，避免释放后重新分配
+                auto last = std::prev(items_.end());
+                index_.erase(last->first);
+                last->first = key;
+                last->second = std::move(value);
+                items_.splice(items_.begin(), items_, last);
+            }
+            else
+                items_.emplace_front(key, std::move(value));
+            index_.emplace(items_.front().first, items_.begin());
+            return items_.front().second;
+        }
+
+        void clear()
+        {
+            index_.clear();
+            items_.clear();
+        }
+
+        size_t size() const
+        {
+            return items_.size();
+        }
+
+        size_t capacity() const
+        {
+            return capacity_;
+        }
+
+    private:
+        size_t capacity_;
+        std::list<item_t> items_;
+        std::unordered_map<Key, iterator_t, Hash> index_;
+    };
+}
+
+#endif
@@ -0,0 +1,230 @@
+#ifndef __bs_manifest_h__
+#define __bs_manifest_h__
+
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <chrono>
+#include <boost_search/base/log.h>
+#include <boost_search/base/public_data.h>
+#include <boost_search/utils/common_op.h>
+
+namespace bs_manifest
+{
+    using namespace bs_log_system;
+
+    /**
+     * 解析清单，记录文本文件中每个HTML文件对应的文档信息
+     * 1. 文本文件在两次全量解析之间只追加不修改，文档ID就是记录在文本文件中的行号
+     * 2. 清单中只保存仍然有效的文档，文本文件中不在清单内的行视为已删除（墓碑）
+     * 3. 全量解析会重写文本文件并生成新的版本号，索引根据版本号判断能否增量更新
+     * 4. 清单记录保存时文本文件的字节数，文本文件超出的部分是清单保存前中断的追加，增量解析前截断
+     *
+     * 文件格式：
+     * 第一行：版本号\3文本文件记录数\3文本文件字节数
+     * 其余每行：文件路径\3修改时间\3文件大小\3内容哈希\3文档ID
+     */
+
+    // 单个HTML文件的信息
+    struct ManifestEntry
+    {
+        std::string path;
+        int64_t mtime;   // 修改时间
+        uint64_t size;   // 文件大小
+        uint64_t hash;   // 内容哈希
+        uint64_t doc_id; // 文档ID，即文本文件中的行号
+    };
+
+    // 根据文本文件路径获取清单路径
+    inline std::filesystem::path getManifestPath(const std::filesystem::path &raw_path)
+    {
+        return raw_path.string() + ".manifest";
+    }
+
+    // FNV-1a哈希，用于判断文件内容是否变化
+    inline uint64_t hashContent(std::string_view data)
+    {
+        uint64_t h = 14695981039346656037ULL;
+        for (unsigned char c : data)
+        {
+            h ^= c;
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    // 获取文件修改时间
+    inline int64_t getFileMtime(const std::filesystem::path &p)
+    {
+        std::error_code ec;
+        auto t = std::filesystem::last_write_time(p, ec);
+        if (ec)
+            return 0;
+        return static_cast<int64_t>(t.time_since_epoch().count());
+    }
+
+    class Manifest
+    {
+    public:
+        Manifest()
+            : generation_(0), doc_count_(0), raw_size_(0)
+        {
+        }
+
+        // 生成新的版本号，全量解析时使用
+        void resetGeneration()
+        {
+            generation_ = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+            doc_count_ = 0;
+            raw_size_ = 0;
+            entries_.clear();
+        }
+
+        bool load(const std::filesystem::path &path)
+        {
+            std::ifstream in(path, std::ios::binary);
+            if (!in.is_open())
+                return false;
+
+            std::string line;
+            std::vector<std::string> fields;
+            if (!getline(in, line) || bs_common_op::CommonOp::split(fields, line, bs_public_data::g_rd_sep) != 3)
+            {
+                LOG(Level::Warning, "清单文件格式错误");
+                return false;
+            }
+            try
+            {
+                generation_ = std::stoull(fields[0]);
+                doc_count_ = std::stoull(fields[1]);
+                raw_size_ = std::stoull(fields[2]);
+            }
+            catch (const std::exception &e)
+            {
+                LOG(Level::Warning, "清单文件格式错误：{}", e.what());
+                return false;
+            }
+
+            entries_.clear();
+            while (getline(in, line))
+            {
+                fields.clear();
+                if (bs_common_op::CommonOp::split(fields, line, bs_public_data::g_rd_sep) != 5)
+                {
+                    LOG(Level::Warning, "清单记录格式错误");
+                    continue;
+                }
+
+                // 截断或者损坏的记录跳过，对应的文件在增量解析时按照新增文件处理
+                ManifestEntry e;
+                try
+                {
+                    e.mtime = std::stoll(fields[1]);
+                    e.size = std::stoull(fields[2]);
+                    e.hash = std::stoull(fields[3]);
+                    e.doc_id = std::stoull(fields[4]);
+                }
+                catch (const std::exception &ex)
+                {
+                    LOG(Level::Warning, "清单记录格式错误：{}", ex.what());
+                    continue;
+                }
+                e.path = std::move(fields[0]);
+                entries_[e.path] = std::move(e);
+            }
+
+            return true;
+        }
+
+        // 先写入临时文件再重命名，保证读取方不会看到写了一半的清单
+        bool save(const std::filesystem::path &path) const
+        {
+            std::ostringstream out;
+            out << generation_ << bs_public_data::g_rd_sep << doc_count_ << bs_public_data::g_rd_sep << raw_size_ << bs_public_data::g_html_sep;
+            for (const auto &pair : entries_)
+            {
+                const ManifestEntry &e = pair.second;
+                out << e.path << bs_public_data::g_rd_sep << e.mtime << bs_public_data::g_rd_sep << e.size
+                    << bs_public_data::g_rd_sep << e.hash << bs_public_data::g_rd_sep << e.doc_id << bs_public_data::g_html_sep;
+            }
+
+            std::filesystem::path tmp = path.string() + ".tmp";
+            {
+                std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+                if (!f.is_open())
+                {
+                    LOG(Level::Warning, "打开清单文件失败");
+                    return false;
+                }
+                std::string data = out.str();
+                f.write(data.data(), data.size());
+                if (!f)
+                {
+                    LOG(Level::Warning, "写入清单文件失败");
+                    return false;
+                }
+            }
+
+            std::error_code ec;
+            std::filesystem::rename(tmp, path, ec);
+            if (ec)
+            {
+                LOG(Level::Warning, "替换清单文件失败：{}", ec.message());
+                return false;
+            }
+
+            return true;
+        }
+
+        uint64_t getGeneration() const
+        {
+            return generation_;
+        }
+
+        // 文本文件中的记录数，也是下一个文档ID
+        uint64_t getDocCount() const
+        {
+            return doc_count_;
+        }
+
+        // 文本文件中属于清单的字节数
+        uint64_t getRawSize() const
+        {
+            return raw_size_;
+        }
+
+        void setRawSize(uint64_t size)
+        {
+            raw_size_ = size;
+        }
+
+        // 分配新的文档ID
+        uint64_t allocateDocId()
+        {
+            return doc_count_++;
+        }
+
+        std::unordered_map<std::string, ManifestEntry> &getEntries()
+        {
+            return entries_;
+        }
+
+        const std::unordered_map<std::string, ManifestEntry> &getEntries() const
+        {
+            return entries_;
+        }
+
+    private:
+        uint64_t generation_;                                   // 版本号，每次全量解析时重新生成
+        uint64_t doc_count_;                                    // 文本文件中的记录数
+        uint64_t raw_size_;                                     // 文本文件的字节数
+        std::unordered_map<std::string, ManifestEntry> entries_; // 文件路径 -> 文件信息
+    };
+}
+
+#endif
@@ -16,6 +16,8 @@ namespace bs_public_data
     const std::string g_html_sep = "\n";
     // 网页根路径
     const std::string root_path = "/home/epsda/BoostSearchingEngine_ReactorServer/boost_search/demo/wwwroot";
+    // 用于拼接的官网URL，正排索引中的URL只保存这之后的相对路径
+    const std::string g_url_to_concat = "https://www.boost.org/doc/libs/1_78_0/doc/html";
 
     // 结果基本内容结构
     struct ResultData
@@ -0,0 +1,135 @@
+#ifndef __bs_thread_pool_h__
+#define __bs_thread_pool_h__
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+#include <memory>
+#include <algorithm>
+
+namespace bs_thread_pool
+{
+    /**
+     * 固定大小的计算线程池，用于将一次搜索拆分到多个分片上并行执行
+     * parallelFor的调用线程也会参与执行，线程池为空时退化为串行执行
+     */
+    class ThreadPool
+    {
+    public:
+        using task_t = std::function<void()>;
+
+        explicit ThreadPool(size_t thread_num = 0)
+            : stop_(false)
+        {
+            for (size_t i = 0; i < thread_num; i++)
+                workers_.emplace_back(&ThreadPool::workerLoop, this);
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        ~ThreadPool()
+        {
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                stop_ = true;
+            }
+            cond_.notify_all();
+            for (auto &t : workers_)
+                t.join();
+        }
+
+        size_t getThreadNum() const
+        {
+            return workers_.size();
+        }
+
+        // 对[0, n)中的每一个下标执行fn，所有下标执行完毕后返回
+        void parallelFor(size_t n, const std::function<void(size_t)> &fn)
+        {
+            if (n == 0)
+                return;
+            if (workers_.empty() || n == 1)
+            {
+                for (size_t i = 0; i < n; i++)
+                    fn(i);
+                return;
+            }
+
+            // 下标由调用线程和工作线程共同领取
+            // 状态由共享指针管理，领取不到下标的工作线程可能在本函数返回之后才开始执行
+            struct ForState
+            {
+                std::mutex mtx;
+                std::condition_variable done;
+                size_t next = 0;
+                size_t finished = 0;
+            };
+            auto state = std::make_shared<ForState>();
+            const std::function<void(size_t)> *func = &fn;
+            auto runner = [state, func, n]()
+            {
+                while (true)
+                {
+                    size_t i;
+                    {
+                        std::unique_lock<std::mutex> lock(state->mtx);
+                        if (state->next >= n)
+                            return;
+                        i = state->next++;
+                    }
+                    // 领取到下标时调用者一定还在等待，func仍然有效
+                    (*func)(i);
+                    std::unique_lock<std::mutex> lock(state->mtx);
+                    if (++state->finished == n)
+                        state->done.notify_one();
+                }
+            };
+
+            size_t helpers = std::min(workers_.size(), n - 1);
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                for (size_t i = 0; i < helpers; i++)
+                    tasks_.push_back(runner);
+            }
+            cond_.notify_all();
+
+            runner();
+            std::unique_lock<std::mutex> lock(state->mtx);
+            state->done.wait(lock, [&]()
+                             { return state->finished == n; });
+        }
+
+    private:
+        void workerLoop()
+        {
+            while (true)
+            {
+                task_t task;
+                {
+                    std::unique_lock<std::mutex> lock(mtx_);
+                    cond_.wait(lock, [&]()
+                               { return stop_ || !tasks_.empty(); });
+                    if (stop_ && tasks_.empty())
+                        return;
+                    task = std::move(tasks_.front());
+                    tasks_.pop_front();
+                }
+                task();
+            }
+        }
+
+    private:
+        std::vector<std::thread> workers_;
+        std::deque<task_t> tasks_;
+        std::mutex mtx_;
+        std::condition_variable cond_;
+        bool stop_;
+    };
+}
+
+#endif
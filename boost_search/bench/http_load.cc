@@ -0,0 +1,472 @@
+/*
+    HTTP压测工具，通过回环地址对server进行压测
+    使用方式：
+    ./http_load [-h ip] [-p port] [-c 连接数] [-t 线程数] [-d 测试秒数] [-w 预热秒数]
+                [-P 流水线深度] [-k 关键字文件] [-z Zipf指数] [-s 静态资源比例] [-o 输出文件] [-n]
+
+    每个线程使用一个epoll管理自己的长连接，每个连接同时最多发送流水线深度个请求
+    -n表示短连接模式，每个连接只发送一个请求，服务端关闭后重新建立连接
+    关键字默认从内置列表按Zipf分布抽取，也可以通过-k指定文件（每行一个关键字）
+    结果以JSON格式输出，便于在部署前对比回归
+*/
+
+#include <getopt.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <algorithm>
+#include <boost_search/base/log.h>
+#include <boost_search/net/socket.h>
+#include <boost_search/utils/url_op.h>
+#include <boost_search/utils/file_op.h>
+
+using namespace bs_log_system;
+
+namespace bs_http_load
+{
+    using clock_t_ = std::chrono::steady_clock;
+
+    // 默认关键字，按常见程度排列，Zipf分布下排在前面的被抽中的概率更高
+    const std::vector<std::string> default_keywords = {
+        "shared_ptr", "asio", "vector", "thread", "filesystem", "string", "function", "bind",
+        "optional", "variant", "any", "regex", "spirit", "mutex", "lock", "socket",
+        "timer", "serialization", "graph", "container", "iterator", "algorithm", "hash", "map",
+        "unordered_map", "lexical_cast", "format", "tokenizer", "date_time", "chrono", "atomic", "coroutine",
+        "fiber", "beast", "json", "property_tree", "program_options", "log", "test", "python",
+        "multi_index", "intrusive", "pool", "circular_buffer", "bimap", "geometry", "math", "random",
+        "interprocess", "uuid"};
+
+    // 静态资源默认请求路径
+    const std::vector<std::string> default_static_paths = {"/", "/index.html"};
+
+    // 压测配置
+    struct LoadConfig
+    {
+        std::string ip = bs_socket::default_ip;
+        uint16_t port = bs_socket::default_port;
+        int connections = 64;
+        int threads = 4;
+        int duration = 10;
+        int warmup = 1;
+        int pipeline = 1;
+        bool short_conn = false;
+        double zipf = 1.0;
+        double static_ratio = 0.1;
+        std::string keyword_file;
+        std::string output_file;
+    };
+
+    // 按照Zipf分布抽取请求路径
+    class RequestPicker
+    {
+    public:
+        RequestPicker(const std::vector<std::string> &keywords, double s, double static_ratio)
+            : static_ratio_(static_ratio)
+        {
+            double sum = 0;
+            for (size_t i = 0; i < keywords.size(); i++)
+            {
+                sum += 1.0 / std::pow(static_cast<double>(i + 1), s);
+                cdf_.push_back(sum);
+
+                std::string encoded;
+                bs_url_op::UrlOp::urlEncode(encoded, keywords[i]);
+                search_paths_.push_back("/search?keyword=" + encoded);
+            }
+            for (auto &c : cdf_)
+                c /= sum;
+        }
+
+        const std::string &pick(std::mt19937_64 &rng) const
+        {
+            std::uniform_real_distribution<double> dist(0.0, 1.0);
+            if (dist(rng) < static_ratio_)
+                return default_static_paths[rng() % default_static_paths.size()];
+
+            size_t idx = std::lower_bound(cdf_.begin(), cdf_.end(), dist(rng)) - cdf_.begin();
+            return search_paths_[std::min(idx, search_paths_.size() - 1)];
+        }
+
+    private:
+        double static_ratio_;
+        std::vector<double> cdf_;               // 累积分布
+        std::vector<std::string> search_paths_; // 已编码的搜索请求路径
+    };
+
+    // 单个长连接的状态
+    struct LoadConnection
+    {
+        bs_socket::Socket::ptr socket;
+        std::string out;                           // 待发送数据
+        std::string in;                            // 已接收但未解析的数据
+        std::deque<size_t> queued;                 // 尚未发送完的请求在out中的结束位置
+        std::deque<clock_t_::time_point> inflight; // 已发送完的请求的发送时间
+        bool writing = false;                      // 是否关注EPOLLOUT
+    };
+
+    // 单个线程的统计结果
+    struct ThreadStats
+    {
+        uint64_t requests = 0;
+        uint64_t errors = 0;
+        uint64_t bytes = 0;
+        std::vector<uint32_t> latencies_us;
+    };
+
+    class LoadWorker
+    {
+    public:
+        LoadWorker(const LoadConfig &conf, const RequestPicker &picker, int conn_num, uint64_t seed)
+            : conf_(conf), picker_(picker), conn_num_(conn_num), rng_(seed), epfd_(epoll_create1(EPOLL_CLOEXEC))
+        {
+        }
+
+        ~LoadWorker()
+        {
+            if (epfd_ >= 0)
+                ::close(epfd_);
+        }
+
+        // 运行到deadline为止，record_from之前完成的请求不计入统计
+        void run(clock_t_::time_point record_from, clock_t_::time_point deadline)
+        {
+            record_from_ = record_from;
+            conns_.resize(conn_num_);
+            for (int i = 0; i < conn_num_; i++)
+                if (!connect(i))
+                    stats_.errors++;
+
+            std::vector<struct epoll_event> events(256);
+            while (clock_t_::now() < deadline)
+            {
+                int nfds = epoll_wait(epfd_, events.data(), events.size(), 100);
+                for (int i = 0; i < nfds; i++)
+                {
+                    int idx = events[i].data.u32;
+                    // 先读取已经到达的响应，再处理连接异常
+                    if (events[i].events & EPOLLIN)
+                    {
+                        if (!handleRead(idx))
+                            reconnect(idx);
+                        continue;
+                    }
+                    if (events[i].events & (EPOLLERR | EPOLLHUP))
+                    {
+                        reconnect(idx);
+                        continue;
+                    }
+                    if (events[i].events & EPOLLOUT)
+                        handleWrite(idx);
+                }
+            }
+
+            conns_.clear();
+        }
+
+        ThreadStats &getStats()
+        {
+            return stats_;
+        }
+
+    private:
+        bool connect(int idx)
+        {
+            LoadConnection &c = conns_[idx];
+            c = LoadConnection();
+            c.socket = std::make_shared<bs_socket::Socket>();
+            if (!c.socket->createClient(conf_.ip, conf_.port))
+                return false;
+            c.socket->setSocketNonBlock();
+
+            // 只在有未发送完的数据时关注EPOLLOUT，否则水平触发的可写事件会让epoll_wait立即返回
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.u32 = idx;
+            epoll_ctl(epfd_, EPOLL_CTL_ADD, c.socket->getSockFd(), &ev);
+
+            // 填满流水线
+            for (int i = 0; i < conf_.pipeline; i++)
+                enqueueRequest(c);
+            handleWrite(idx);
+            return true;
+        }
+
+        void reconnect(int idx)
+        {
+            LoadConnection &c = conns_[idx];
+            stats_.errors += c.inflight.size() + c.queued.size();
+            if (c.socket)
+                epoll_ctl(epfd_, EPOLL_CTL_DEL, c.socket->getSockFd(), nullptr);
+            if (!connect(idx))
+                stats_.errors++;
+        }
+
+        void enqueueRequest(LoadConnection &c)
+        {
+            const std::string &path = picker_.pick(rng_);
+            c.out += "GET ";
+            c.out += path;
+            c.out += " HTTP/1.1\r\nHost: ";
+            c.out += conf_.ip;
+            c.out += conf_.short_conn ? "\r\nConnection: close\r\n\r\n" : "\r\nConnection: keep-alive\r\n\r\n";
+            c.queued.push_back(c.out.size());
+        }
+
+        // 发送待发送数据，请求的最后一个字节写入套接字时开始计时
+        // 发送不完时关注EPOLLOUT，全部发送后取消
+        void handleWrite(int idx)
+        {
+            LoadConnection &c = conns_[idx];
+            while (!c.out.empty())
+            {
+                ssize_t ret = ::send(c.socket->getSockFd(), c.out.data(), c.out.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+                if (ret <= 0)
+                    break;
+                c.out.erase(0, ret);
+
+                auto now = clock_t_::now();
+                size_t sent = static_cast<size_t>(ret);
+                while (!c.queued.empty() && c.queued.front() <= sent)
+                {
+                    c.queued.pop_front();
+                    c.inflight.push_back(now);
+                }
+                for (auto &end : c.queued)
+                    end -= sent;
+            }
+
+            bool want = !c.out.empty();
+            if (want != c.writing)
+            {
+                struct epoll_event ev;
+                ev.events = want ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+                ev.data.u32 = idx;
+                epoll_ctl(epfd_, EPOLL_CTL_MOD, c.socket->getSockFd(), &ev);
+                c.writing = want;
+            }
+        }
+
+        bool handleRead(int idx)
+        {
+            LoadConnection &c = conns_[idx];
+            char buf[65536];
+            bool closed = false;
+            while (true)
+            {
+                ssize_t ret = ::recv(c.socket->getSockFd(), buf, sizeof(buf), MSG_DONTWAIT);
+                if (ret == 0)
+                {
+                    closed = true;
+                    break;
+                }
+                if (ret < 0)
+                {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                        break;
+                    return false;
+                }
+                c.in.append(buf, ret);
+                if (clock_t_::now() >= record_from_)
+                    stats_.bytes += ret;
+            }
+
+            // 解析所有完整的响应
+            size_t consumed = 0;
+            while (true)
+            {
+                size_t header_end = c.in.find("\r\n\r\n", consumed);
+                if (header_end == std::string::npos)
+                    break;
+                size_t body_len = getContentLength(std::string_view(c.in).substr(consumed, header_end - consumed));
+                size_t total = header_end + 4 + body_len;
+                if (total > c.in.size())
+                    break;
+
+                bool ok = c.in.compare(consumed + 9, 3, "200") == 0;
+                consumed = total;
+                if (c.inflight.empty())
+                    return false;
+                auto now = clock_t_::now();
+                if (now >= record_from_)
+                {
+                    if (ok)
+                    {
+                        stats_.requests++;
+                        stats_.latencies_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(now - c.inflight.front()).count());
+                    }
+                    else
+                        stats_.errors++;
+                }
+                c.inflight.pop_front();
+                if (!conf_.short_conn)
+                    enqueueRequest(c);
+            }
+            c.in.erase(0, consumed);
+
+            if (closed)
+            {
+                // 短连接模式下请求已经全部完成时，对端关闭属于正常情况
+                if (!conf_.short_conn || !c.inflight.empty())
+                    return false;
+                epoll_ctl(epfd_, EPOLL_CTL_DEL, c.socket->getSockFd(), nullptr);
+                if (!connect(idx))
+                    stats_.errors++;
+                return true;
+            }
+
+            handleWrite(idx);
+            return true;
+        }
+
+        static size_t getContentLength(std::string_view header)
+        {
+            const std::string_view key = "Content-Length: ";
+            size_t pos = header.find(key);
+            if (pos == std::string_view::npos)
+                return 0;
+            return std::strtoul(header.data() + pos + key.size(), nullptr, 10);
+        }
+
+    private:
+        const LoadConfig &conf_;
+        const RequestPicker &picker_;
+        int conn_num_;
+        std::mt19937_64 rng_;
+        int epfd_;
+        clock_t_::time_point record_from_;
+        std::vector<LoadConnection> conns_;
+        ThreadStats stats_;
+    };
+
+    // 计算百分位延迟
+    uint32_t percentile(const std::vector<uint32_t> &sorted, double p)
+    {
+        if (sorted.empty())
+            return 0;
+        size_t idx = static_cast<size_t>(p * (sorted.size() - 1));
+        return sorted[idx];
+    }
+}
+
+using namespace bs_http_load;
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "用法：%s [-h ip] [-p port] [-c 连接数] [-t 线程数] [-d 测试秒数] [-w 预热秒数] "
+                    "[-P 流水线深度] [-k 关键字文件] [-z Zipf指数] [-s 静态资源比例] [-o 输出文件] [-n]\n",
+            name);
+}
+
+int main(int argc, char *argv[])
+{
+    LoadConfig conf;
+    int opt;
+    while ((opt = getopt(argc, argv, "h:p:c:t:d:w:P:k:z:s:o:n")) != -1)
+    {
+        switch (opt)
+        {
+        case 'h': conf.ip = optarg; break;
+        case 'p': conf.port = std::stoi(optarg); break;
+        case 'c': conf.connections = std::stoi(optarg); break;
+        case 't': conf.threads = std::stoi(optarg); break;
+        case 'd': conf.duration = std::stoi(optarg); break;
+        case 'w': conf.warmup = std::stoi(optarg); break;
+        case 'P': conf.pipeline = std::stoi(optarg); break;
+        case 'k': conf.keyword_file = optarg; break;
+        case 'z': conf.zipf = std::stod(optarg); break;
+        case 's': conf.static_ratio = std::stod(optarg); break;
+        case 'o': conf.output_file = optarg; break;
+        case 'n': conf.short_conn = true; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (conf.threads <= 0 || conf.connections < conf.threads || conf.pipeline <= 0 || conf.duration <= 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    // 短连接模式下每个连接只有一个请求
+    if (conf.short_conn)
+        conf.pipeline = 1;
+
+    // 读取关键字
+    std::vector<std::string> keywords = default_keywords;
+    if (!conf.keyword_file.empty())
+    {
+        std::ifstream ifs(conf.keyword_file);
+        if (!ifs.is_open())
+        {
+            LOG(Level::Error, "打开关键字文件：{}失败", conf.keyword_file);
+            return 1;
+        }
+        keywords.clear();
+        std::string line;
+        while (std::getline(ifs, line))
+            if (!line.empty())
+                keywords.push_back(line);
+        if (keywords.empty())
+        {
+            LOG(Level::Error, "关键字文件为空");
+            return 1;
+        }
+    }
+
+    RequestPicker picker(keywords, conf.zipf, conf.static_ratio);
+
+    auto start = clock_t_::now();
+    auto record_from = start + std::chrono::seconds(conf.warmup);
+    auto deadline = record_from + std::chrono::seconds(conf.duration);
+
+    std::vector<std::unique_ptr<LoadWorker>> workers;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < conf.threads; i++)
+    {
+        // 连接均分到每个线程
+        int conn_num = conf.connections / conf.threads + (i < conf.connections % conf.threads ? 1 : 0);
+        workers.push_back(std::make_unique<LoadWorker>(conf, picker, conn_num, 0x9e3779b97f4a7c15ULL * (i + 1)));
+    }
+    for (auto &w : workers)
+        threads.emplace_back([&w, record_from, deadline]()
+                             { w->run(record_from, deadline); });
+    for (auto &t : threads)
+        t.join();
+
+    // 汇总结果
+    ThreadStats total;
+    for (auto &w : workers)
+    {
+        ThreadStats &s = w->getStats();
+        total.requests += s.requests;
+        total.errors += s.errors;
+        total.bytes += s.bytes;
+        total.latencies_us.insert(total.latencies_us.end(), s.latencies_us.begin(), s.latencies_us.end());
+    }
+    std::sort(total.latencies_us.begin(), total.latencies_us.end());
+
+    double seconds = static_cast<double>(conf.duration);
+    std::string result = fmt::format(
+        "{{\"connections\":{},\"threads\":{},\"pipeline\":{},\"short_conn\":{},\"duration_s\":{},\"requests\":{},\"errors\":{},"
+        "\"throughput_rps\":{:.1f},\"throughput_mib_s\":{:.2f},"
+        "\"latency_us\":{{\"p50\":{},\"p90\":{},\"p99\":{},\"p999\":{},\"max\":{}}}}}\n",
+        conf.connections, conf.threads, conf.pipeline, conf.short_conn, conf.duration, total.requests, total.errors,
+        total.requests / seconds, total.bytes / seconds / (1024.0 * 1024.0),
+        percentile(total.latencies_us, 0.50), percentile(total.latencies_us, 0.90),
+        percentile(total.latencies_us, 0.99), percentile(total.latencies_us, 0.999),
+        total.latencies_us.empty() ? 0 : total.latencies_us.back());
+
+    if (conf.output_file.empty())
+        fwrite(result.data(), 1, result.size(), stdout);
+    else if (!bs_file_op::FileOp::writeFile(conf.output_file, result))
+        return 1;
+
+    return 0;
+}
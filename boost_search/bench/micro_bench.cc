@@ -0,0 +1,579 @@
+/*
+    热点模块微基准测试，输出每次操作耗时（ns/op）和每次操作的内存分配次数（allocs/op）
+    使用方式：
+    ./micro_bench [-f 名称过滤] [-n 文档数] [-r 文本文件]
+
+    默认使用固定随机种子生成的语料，保证每次运行的输入一致，便于对比单项优化的效果
+    -r可以指定parse生成的真实文本文件
+*/
+
+#include <getopt.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <random>
+#include <cstdlib>
+#include <boost_search/base/data_parse.h>
+#include <boost_search/search/search_engine.h>
+#include <boost_search/net/http/http_context.h>
+#include <boost_search/net/event_loop_lock_queue.h>
+#include <boost_search/utils/file_op.h>
+#include <boost_search/utils/url_op.h>
+
+using namespace bs_log_system;
+
+// 统计内存分配次数和分配的字节数
+static std::atomic<uint64_t> g_alloc_count{0};
+static std::atomic<uint64_t> g_alloc_bytes{0};
+
+void *operator new(size_t size)
+{
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace bs_micro_bench
+{
+    using clock_t_ = std::chrono::steady_clock;
+
+    // 单项测试最短运行时间
+    const auto min_bench_time = std::chrono::milliseconds(200);
+    // 生成语料默认路径
+    const std::filesystem::path default_corpus_path = "micro_bench_corpus.raw";
+
+    // 防止编译器优化掉测试结果
+    template <class T>
+    void doNotOptimize(T &&value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    class MicroBench
+    {
+    public:
+        MicroBench(const std::string &filter)
+            : filter_(filter)
+        {
+        }
+
+        // 自动增加迭代次数直到运行时间超过min_bench_time，再输出平均结果
+        // max_iters用于限制会持续占用内存的测试项
+        template <class F>
+        void run(const std::string &name, F &&fn, uint64_t max_iters = (1ULL << 30))
+        {
+            if (!filter_.empty() && name.find(filter_) == std::string::npos)
+                return;
+
+            uint64_t iters = 1;
+            while (true)
+            {
+                uint64_t allocs = g_alloc_count.load(std::memory_order_relaxed);
+                auto start = clock_t_::now();
+                for (uint64_t i = 0; i < iters; i++)
+                    fn();
+                auto cost = clock_t_::now() - start;
+                allocs = g_alloc_count.load(std::memory_order_relaxed) - allocs;
+
+                if (cost >= min_bench_time || iters >= max_iters)
+                {
+                    double ns = std::chrono::duration<double, std::nano>(cost).count() / iters;
+                    fmt::print("{:<40} {:>12} {:>16.1f} ns/op {:>12.2f} allocs/op\n", name, iters, ns, static_cast<double>(allocs) / iters);
+                    return;
+                }
+                iters *= 2;
+            }
+        }
+
+    private:
+        std::string filter_;
+    };
+
+    // 生成固定语料：标题、正文由词表中的词组成，正文按照Zipf分布取词
+    bool generateCorpus(const std::filesystem::path &path, int docs)
+    {
+        const std::vector<std::string> base_words = {
+            "boost", "the", "of", "and", "shared_ptr", "asio", "vector", "thread", "filesystem", "string",
+            "function", "bind", "optional", "variant", "regex", "spirit", "mutex", "socket", "timer", "graph",
+            "container", "iterator", "algorithm", "hash", "map", "template", "class", "member", "type", "value",
+            "return", "const", "reference", "pointer", "allocator", "exception", "library", "header", "namespace", "example"};
+
+        std::mt19937_64 rng(20250101);
+        std::vector<std::string> vocab = base_words;
+        // 补充随机单词，模拟长尾词汇
+        for (int i = 0; i < 2000; i++)
+        {
+            std::string w;
+            int len = 3 + rng() % 8;
+            for (int j = 0; j < len; j++)
+                w += static_cast<char>('a' + rng() % 26);
+            vocab.push_back(w);
+        }
+
+        std::vector<double> cdf;
+        double sum = 0;
+        for (size_t i = 0; i < vocab.size(); i++)
+        {
+            sum += 1.0 / static_cast<double>(i + 1);
+            cdf.push_back(sum);
+        }
+        std::uniform_real_distribution<double> dist(0.0, sum);
+        auto pick = [&]() -> const std::string &
+        {
+            size_t idx = std::lower_bound(cdf.begin(), cdf.end(), dist(rng)) - cdf.begin();
+            return vocab[std::min(idx, vocab.size() - 1)];
+        };
+
+        std::string out;
+        for (int d = 0; d < docs; d++)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                out += pick();
+                out += ' ';
+            }
+            out += bs_public_data::g_rd_sep;
+            int body_words = 200 + rng() % 800;
+            for (int i = 0; i < body_words; i++)
+            {
+                out += pick();
+                out += (i % 17 == 16) ? ". " : " ";
+            }
+            out += bs_public_data::g_rd_sep;
+            out += bs_data_parse::g_url_to_concat;
+            // 按照库分目录，与Boost文档的URL结构一致
+            out += "/lib_" + std::to_string(d % 32) + "/doc_" + std::to_string(d) + ".html";
+            out += bs_public_data::g_html_sep;
+        }
+
+        return bs_file_op::FileOp::writeFile(path, out);
+    }
+
+    // 生成模拟Boost文档结构的HTML页面，包含较多标签、换行和实体
+    std::string generateHtml(int paragraphs)
+    {
+        std::string html = "<html>\n<head>\n<meta http-equiv=\"Content-Type\" content=\"text/html; charset=US-ASCII\">\n"
+                           "<title>Chapter&#160;1.&#160;Boost.Asio</title>\n</head>\n<body bgcolor=\"white\">\n";
+        for (int i = 0; i < paragraphs; i++)
+        {
+            html += "<div class=\"section\"><h3 class=\"title\"><a name=\"sec_" + std::to_string(i) + "\"></a>Section " + std::to_string(i) + "</h3></div>\n";
+            html += "<p>\nThe <code class=\"computeroutput\"><span class=\"identifier\">io_context</span></code> class provides the core I/O\n"
+                    "functionality for users of the asynchronous I/O objects, including &lt;socket&gt; &amp; timer.\n</p>\n";
+            html += "<pre class=\"programlisting\"><span class=\"identifier\">std</span><span class=\"special\">::</span>"
+                    "<span class=\"identifier\">vector</span><span class=\"special\">&lt;</span><span class=\"keyword\">int</span>"
+                    "<span class=\"special\">&gt;</span> <span class=\"identifier\">v</span><span class=\"special\">;</span>\n</pre>\n";
+        }
+        html += "</body>\n</html>\n";
+        return html;
+    }
+
+    // 在整个正文中忽略大小写查找关键字再截取摘要，作为getSnippet的对照
+    std::string legacyPartialBody(std::string_view body, std::string_view keyword)
+    {
+        auto pos_t = std::search(body.begin(), body.end(), keyword.begin(), keyword.end(), [](char c1, char c2)
+                                 { return std::tolower(c1) == std::tolower(c2); });
+        if (pos_t == body.end())
+            return "";
+        size_t pos = pos_t - body.begin();
+        size_t start = pos > 50 ? pos - 50 : 0;
+        size_t end = std::min(body.size(), pos + keyword.size() + 100);
+        return std::string(body.substr(start, end - start));
+    }
+
+    // 逐字节状态机实现的去标签，作为getContentFromHtml的对照
+    void legacyStripTags(const std::string &out, std::string *body)
+    {
+        bool label = true;
+        for (char ch : out)
+        {
+            if (label)
+            {
+                if (ch == '>')
+                    label = false;
+            }
+            else if (ch == '<')
+                label = true;
+            else
+                *body += (ch == '\n') ? ' ' : ch;
+        }
+    }
+}
+
+using namespace bs_micro_bench;
+
+int main(int argc, char *argv[])
+{
+    std::string filter;
+    std::string raw_file;
+    int docs = 2000;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:n:r:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f': filter = optarg; break;
+        case 'n': docs = std::stoi(optarg); break;
+        case 'r': raw_file = optarg; break;
+        default:
+            fprintf(stderr, "用法：%s [-f 名称过滤] [-n 文档数] [-r 文本文件]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // 基准测试过程中只输出错误日志
+    ls->setLevel(Level::Error);
+
+    std::filesystem::path corpus = raw_file;
+    if (corpus.empty())
+    {
+        corpus = default_corpus_path;
+        if (!generateCorpus(corpus, docs))
+            return 1;
+    }
+
+    MicroBench bench(filter);
+    bs_search_index::SearchIndex index;
+
+    // 索引构建
+    bench.run("SearchIndex::buildIndex", [&]()
+              {
+                  index.clear();
+                  index.buildIndex(corpus);
+              });
+
+    // 索引规模：倒排节点数和位置信息大小，用于对比剪枝前后的变化
+    if (index.getDocCount() > 0)
+    {
+        size_t postings = 0, position_bytes = 0, common_postings = 0;
+        size_t field_postings[bs_search_index::field_count] = {0};
+        for (size_t i = 0; i < index.getShardNum(); i++)
+        {
+            postings += index.getShard(i).posting_cnt;
+            position_bytes += index.getShard(i).positions.size();
+            for (const auto &common : index.getShard(i).common_postings)
+                common_postings += common.size();
+            for (size_t f = 0; f < bs_search_index::field_count; f++)
+            {
+                for (const auto &ids : index.getShard(i).fields[f].doc_ids)
+                    field_postings[f] += ids.size();
+            }
+        }
+        fmt::print("文档数：{}，倒排节点数：{}（其中高频词只保留文档ID、权重和正文偏移：{}），位置信息：{}字节，高频词：{}\n",
+                   index.getDocCount(), postings, common_postings, position_bytes, index.getCommonTermCount());
+        fmt::print("标题倒排节点数：{}，URL倒排节点数：{}\n", field_postings[bs_search_index::field_title], field_postings[bs_search_index::field_url]);
+        const auto &forward = index.getForwardIndex();
+        const auto &bodies = forward.getBodyStore();
+        fmt::print("正文：{}字节，压缩后：{}字节，标题和URL：{}字节\n", bodies.rawBytes(), bodies.memoryBytes(), forward.memoryBytes());
+    }
+
+    // 搜索，引擎构造时会建立自己的索引
+    bs_search_engine::SearchEngine engine(corpus);
+    std::string json_string;
+    // 不分页时每个结果都要截取摘要，正文分散在各个压缩块中，用于发现摘要路径的退化
+    bench.run("SearchEngine::search/single", [&]()
+              {
+                  std::string keyword = "shared_ptr";
+                  engine.search(keyword, json_string);
+                  doNotOptimize(json_string);
+              });
+    // 与/search相同的分页请求：默认每页10个结果，以及允许的最大页100个结果
+    bench.run("SearchEngine::search/single/page", [&]()
+              {
+                  std::string keyword = "shared_ptr";
+                  engine.search(keyword, json_string, 10, 20);
+                  doNotOptimize(json_string);
+              });
+    bench.run("SearchEngine::search/single/page100", [&]()
+              {
+                  std::string keyword = "shared_ptr";
+                  engine.search(keyword, json_string, 100, 100);
+                  doNotOptimize(json_string);
+              });
+    bench.run("SearchEngine::search/multi", [&]()
+              {
+                  std::string keyword = "asio socket timer";
+                  engine.search(keyword, json_string);
+                  doNotOptimize(json_string);
+              });
+
+    // 分片并行搜索，分片数与CPU核心数一致
+    size_t shard_num = std::max(2u, std::thread::hardware_concurrency());
+    bs_search_engine::SearchEngine sharded_engine(corpus, shard_num);
+    bench.run("SearchEngine::search/multi/shards" + std::to_string(shard_num), [&]()
+              {
+                  std::string keyword = "asio socket timer";
+                  sharded_engine.search(keyword, json_string);
+                  doNotOptimize(json_string);
+              });
+    bench.run("SearchEngine::search/multi/top10", [&]()
+              {
+                  std::string keyword = "asio socket timer";
+                  engine.search(keyword, json_string, 10);
+                  doNotOptimize(json_string);
+              });
+
+    bench.run("SearchEngine::search/phrase", [&]()
+              {
+                  std::string keyword = "\"the of\" boost";
+                  engine.search(keyword, json_string, 10);
+                  doNotOptimize(json_string);
+              });
+
+    bench.run("SearchEngine::search/and", [&]()
+              {
+                  std::string keyword = "+asio +socket -timer";
+                  engine.search(keyword, json_string, 10);
+                  doNotOptimize(json_string);
+              });
+
+    // 限定标题与同样的词在全文中必须包含对比
+    bench.run("SearchEngine::search/title", [&]()
+              {
+                  std::string keyword = "title:asio title:socket";
+                  engine.search(keyword, json_string, 10);
+                  doNotOptimize(json_string);
+              });
+    bench.run("SearchEngine::search/title/fulltext", [&]()
+              {
+                  std::string keyword = "+asio +socket";
+                  engine.search(keyword, json_string, 10);
+                  doNotOptimize(json_string);
+              });
+
+    // 按库统计结果数，以及限定库的搜索
+    bench.run("SearchEngine::facets", [&]()
+              {
+                  std::string keyword = "asio socket timer";
+                  engine.facets(keyword, json_string);
+                  doNotOptimize(json_string);
+              });
+    bench.run("SearchEngine::search/lib", [&]()
+              {
+                  std::string keyword = "lib=lib_3 asio socket timer";
+                  engine.search(keyword, json_string, 10);
+                  doNotOptimize(json_string);
+              });
+    bench.run("SearchEngine::search/lib/only", [&]()
+              {
+                  std::string keyword = "lib=lib_3";
+                  engine.search(keyword, json_string, 10);
+                  doNotOptimize(json_string);
+              });
+
+    // 前缀补全：短前缀命中预先计算的结果，长前缀扫描区间
+    bench.run("SearchEngine::suggest/1byte", [&]()
+              {
+                  engine.suggest("s", json_string);
+                  doNotOptimize(json_string);
+              });
+    bench.run("SearchEngine::suggest/4byte", [&]()
+              {
+                  engine.suggest("shar", json_string);
+                  doNotOptimize(json_string);
+              });
+
+    // 摘要截取
+    if (index.getDocCount() == 0)
+        index.buildIndex(corpus);
+    bool has_doc = index.getDocCount() > 0;
+    std::string body(has_doc ? index.getBody(0) : std::string_view());
+    if (has_doc)
+    {
+        uint32_t anchor = index.getBodyOffset(index.getTermDictionary().find("algorithm"), 0);
+        std::vector<std::string_view> terms = {"algorithm", "boost"};
+        bench.run("SearchEngine::getSnippet", [&]()
+                  {
+                      std::string part = bs_search_engine::SearchEngine::getSnippet(body, anchor, terms);
+                      doNotOptimize(part);
+                  });
+        bench.run("SearchEngine::getSnippet/legacy", [&]()
+                  {
+                      std::string part = legacyPartialBody(body, "algorithm");
+                      doNotOptimize(part);
+                  });
+    }
+
+    // 读取正文：同一个块命中线程缓存，以及每次都读取不同的块需要解压
+    if (index.getDocCount() > 0)
+    {
+        size_t doc_cnt = index.getDocCount();
+        bench.run("SearchIndex::getBody/hit", [&]()
+                  {
+                      std::string_view part = index.getBody(0);
+                      doNotOptimize(part);
+                  });
+        // 跨越的块数远多于线程缓存的容量，每次读取都需要解压一个块
+        size_t step = doc_cnt / (bs_doc_store::block_cache_capacity * 4) + 1;
+        uint64_t next = 0;
+        bench.run("SearchIndex::getBody/miss", [&]()
+                  {
+                      std::string_view part = index.getBody(next);
+                      next = (next + step) % doc_cnt;
+                      doNotOptimize(part);
+                  });
+    }
+
+    // 分词：ASCII快速路径与全部交给Jieba再转小写对比
+    if (has_doc)
+    {
+        bs_tokenizer::Tokenizer tokenizer;
+        cppjieba::Jieba jieba;
+        std::vector<cppjieba::Word> words;
+        bench.run("Tokenizer::cutForSearch/body", [&]()
+                  {
+                      words.clear();
+                      tokenizer.cutForSearch(body, words);
+                      doNotOptimize(words);
+                  });
+        bench.run("Tokenizer::cutForSearch/legacy", [&]()
+                  {
+                      words.clear();
+                      jieba.CutForSearch(body, words);
+                      for (auto &w : words)
+                          boost::to_lower(w.word);
+                      doNotOptimize(words);
+                  });
+    }
+
+    // 词典查找：只读词典与unordered_map对比，查询词按照固定随机顺序取自词表，其中四分之一不存在
+    const auto &dict = index.getTermDictionary();
+    if (dict.size() > 0)
+    {
+        std::vector<std::string> queries;
+        std::mt19937_64 rng(20250202);
+        for (int i = 0; i < 4096; i++)
+        {
+            std::string term(dict.getTerm(rng() % dict.size()));
+            if (i % 4 == 3)
+                term += "#";
+            queries.push_back(std::move(term));
+        }
+
+        // 预留桶数组避免扩容，分配的字节数即为哈希表实际占用的内存
+        uint64_t bytes = g_alloc_bytes.load(std::memory_order_relaxed);
+        std::unordered_map<std::string, uint32_t> term_map;
+        term_map.reserve(dict.size());
+        for (uint32_t i = 0; i < dict.size(); i++)
+            term_map.emplace(std::string(dict.getTerm(i)), i);
+        bytes = g_alloc_bytes.load(std::memory_order_relaxed) - bytes;
+        fmt::print("词数：{}，unordered_map占用：{}字节，TermDictionary占用：{}字节\n", dict.size(), bytes, dict.memoryBytes());
+
+        size_t qi = 0;
+        bench.run("TermDictionary::find", [&]()
+                  {
+                      uint32_t id = dict.find(queries[qi++ & 4095]);
+                      doNotOptimize(id);
+                  });
+        qi = 0;
+        bench.run("TermDictionary::find/unordered_map", [&]()
+                  {
+                      auto pos = term_map.find(queries[qi++ & 4095]);
+                      doNotOptimize(pos);
+                  });
+        qi = 0;
+        bench.run("TermDictionary::prefixRange", [&]()
+                  {
+                      const std::string &q = queries[qi++ & 4095];
+                      auto range = dict.prefixRange(std::string_view(q).substr(0, 2));
+                      doNotOptimize(range);
+                  });
+    }
+
+    // HTTP请求解析
+    const std::string request =
+        "GET /search?keyword=shared_ptr%20cast HTTP/1.1\r\n"
+        "Host: 127.0.0.1:8080\r\n"
+        "Connection: keep-alive\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/126.0 Safari/537.36\r\n"
+        "Accept: application/json, text/javascript, */*; q=0.01\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+        "Referer: http://127.0.0.1:8080/\r\n"
+        "\r\n";
+    bench.run("HttpContext::constructHttpRequest", [&]()
+              {
+                  bs_buffer::Buffer buf;
+                  buf.write_move(request, request.size());
+                  bs_http_context::HttpContext context;
+                  context.constructHttpRequest(buf);
+                  doNotOptimize(context);
+              });
+
+    // 缓冲区读写
+    bs_buffer::Buffer buffer;
+    std::string chunk(512, 'x');
+    std::string out;
+    bench.run("Buffer::write_move+read_move/512B", [&]()
+              {
+                  buffer.write_move(chunk, chunk.size());
+                  buffer.read_move(out, chunk.size());
+              });
+    bench.run("Buffer::readLine_move", [&]()
+              {
+                  buffer.write_move(request, request.size());
+                  std::string line;
+                  do
+                  {
+                      line.clear();
+                      buffer.readLine_move(line);
+                  } while (!line.empty());
+                  buffer.clear();
+              });
+
+    // URL解码
+    const std::string encoded = "%E5%85%B3%E9%94%AE%E5%AD%97+shared_ptr%3A%3Acast%20boost%2Fasio";
+    bench.run("UrlOp::urlDecode", [&]()
+              {
+                  std::string decoded;
+                  bs_url_op::UrlOp::urlDecode(decoded, encoded, true);
+                  doNotOptimize(decoded);
+              });
+
+    // HTML去标签
+    std::string html = generateHtml(200);
+    bs_data_parse::DataParse parser;
+    bench.run("DataParse::getContentFromHtml/" + std::to_string(html.size() / 1024) + "KiB", [&]()
+              {
+                  std::string body;
+                  parser.getContentFromHtml(html, &body);
+                  doNotOptimize(body);
+              });
+    bench.run("DataParse::getContentFromHtml/legacy", [&]()
+              {
+                  std::string body;
+                  legacyStripTags(html, &body);
+                  doNotOptimize(body);
+              });
+
+    // 时间轮插入与刷新，在事件循环所在线程内直接执行
+    // 测试过程中不推进时间轮，任务会一直保留，因此限制最大迭代次数
+    bs_event_loop_lock_queue::EventLoopLockQueue loop;
+    const uint64_t max_timer_iters = 1ULL << 16;
+    std::vector<std::string> ids;
+    for (int i = 0; i < 1024; i++)
+    {
+        ids.push_back("refresh_" + std::to_string(i));
+        loop.insertTask(ids.back(), 30, []() {});
+    }
+    uint64_t timer_id = 0;
+    bench.run("TimingWheel::insertTask", [&]()
+              { loop.insertTask(std::to_string(timer_id++), 30, []() {}); },
+              max_timer_iters);
+    bench.run("TimingWheel::refreshTask", [&]()
+              { loop.refreshTask(ids[timer_id++ % ids.size()]); },
+              max_timer_iters);
+
+    return 0;
+}
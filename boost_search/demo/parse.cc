@@ -1,13 +1,31 @@
+#include <getopt.h>
 #include <boost_search/base/data_parse.h>
 
 using namespace bs_data_parse;
 
-int main()
+// 用法：./parse [-t 解析线程数] [-i]
+// -t 指定解析线程数，默认与CPU核心数一致
+// -i 增量解析，只处理上一次解析之后新增、修改和删除的文件
+int main(int argc, char *argv[])
 {
+    size_t thread_num = std::thread::hardware_concurrency();
+    bool incremental = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:i")) != -1)
+    {
+        switch (opt)
+        {
+        case 't': thread_num = std::stoi(optarg); break;
+        case 'i': incremental = true; break;
+        default:
+            fprintf(stderr, "用法：%s [-t 解析线程数] [-i]\n", argv[0]);
+            return 1;
+        }
+    }
+
     DataParse d;
-    d.getHtmlSourceFiles();
-    d.readInfoFromHtml();
-    d.writeToRawFile();
+    if (incremental)
+        return d.parseIncremental(thread_num) ? 0 : 1;
 
-    return 0;
-}
\ No newline at end of file
+    return d.parseAndWriteStreaming(thread_num) ? 0 : 1;
+}
@@ -1,8 +1,27 @@
+#include <signal.h>
+#include <pthread.h>
 #include <boost_search/search/search_engine.h>
 #include <boost_search/net/http/http_server.h>
 
 using namespace bs_log_system;
 
+// /search每页默认返回的结果数和允许请求的最大结果数，只有返回的结果需要截取摘要
+const size_t default_page_size = 10;
+const size_t max_page_size = 100;
+
+// 读取非负整数参数，不存在或者格式错误时返回def
+size_t getSizeParam(bs_http_request::HttpRequest& req, const std::string &key, size_t def)
+{
+    if(!req.isInParams(key))
+        return def;
+    std::string val = req.getParam(key);
+    if(val.empty() || val.size() > 9 || val.find_first_not_of("0123456789") != std::string::npos)
+        return def;
+    return std::stoul(val);
+}
+
+// 搜索：/search?keyword=xxx[&offset=0][&limit=10]
+// 返回跳过前offset个结果之后的limit个结果，满足查询的文档总数通过X-Total-Count响应头返回
 void run(bs_search_engine::SearchEngine& s_engine, bs_http_request::HttpRequest& req, bs_http_response::HttpResponse &resp)
 {
     // 如果不存在word，说明在请求不存在的页面，返回404
@@ -19,17 +38,117 @@ void run(bs_search_engine::SearchEngine& s_engine, bs_http_request::HttpRequest&
     // 此时说明存在对应的值，获取值
     auto val = req.getParam("keyword");
 
+    size_t offset = getSizeParam(req, "offset", 0);
+    size_t limit = std::min(getSizeParam(req, "limit", default_page_size), max_page_size);
+    if(limit == 0)
+        limit = default_page_size;
+
     // 执行搜索
     std::string json_string;
-    s_engine.search(val, json_string);
+    size_t total = s_engine.search(val, json_string, limit, offset);
 
     LOG(Level::Info, "搜索关键词: {}", val);
-    resp.setBody(json_string, "application/json");
+    resp.setBody(std::move(json_string), "application/json");
+    resp.setHeader("X-Total-Count", std::to_string(total));
+}
+
+// 前缀补全：/suggest?prefix=xxx，没有前缀时返回空数组
+void suggest(bs_search_engine::SearchEngine& s_engine, bs_http_request::HttpRequest& req, bs_http_response::HttpResponse &resp)
+{
+    std::string json_string;
+    if(!req.isInParams("prefix") || req.getParam("prefix").empty())
+        json_string = "[]";
+    else
+        s_engine.suggest(req.getParam("prefix"), json_string);
+
+    resp.setBody(std::move(json_string), "application/json");
+}
+
+// 按库统计结果数：/facets?keyword=xxx，没有关键字时返回空数组
+void facets(bs_search_engine::SearchEngine& s_engine, bs_http_request::HttpRequest& req, bs_http_response::HttpResponse &resp)
+{
+    std::string json_string;
+    if(!req.isInParams("keyword") || req.getParam("keyword").empty())
+        json_string = "[]";
+    else
+    {
+        auto val = req.getParam("keyword");
+        s_engine.facets(val, json_string);
+    }
+
+    resp.setBody(std::move(json_string), "application/json");
+}
+
+// 管理接口只接受本机发起的请求，其他来源返回403
+bool allowAdmin(bs_http_request::HttpRequest& req, bs_http_response::HttpResponse &resp)
+{
+    if (req.getPeerIp().compare(0, 4, "127.") == 0)
+        return true;
+
+    LOG(Level::Warning, "拒绝来自：{}的管理请求：{}", req.getPeerIp(), req.getPath().string());
+    resp.setStatus(403);
+    resp.setBody("{\"status\":\"forbidden\"}", "application/json");
+    return false;
+}
+
+// 管理接口：请求后台重新加载索引，立即返回
+void reload(bs_search_engine::SearchEngine& s_engine, bs_http_request::HttpRequest& req, bs_http_response::HttpResponse &resp)
+{
+    if (!allowAdmin(req, resp))
+        return;
+
+    bool busy = s_engine.isReloading();
+    s_engine.requestReload();
+
+    LOG(Level::Info, "收到重新加载索引请求");
+    resp.setStatus(202);
+    resp.setBody(fmt::format("{{\"status\":\"{}\",\"reload_count\":{}}}", busy ? "queued" : "accepted", s_engine.getReloadCount()), "application/json");
+}
+
+// 管理接口：运行统计，包括查询切分缓存的命中率
+void stats(bs_search_engine::SearchEngine& s_engine, bs_http_request::HttpRequest& req, bs_http_response::HttpResponse &resp)
+{
+    if (!allowAdmin(req, resp))
+        return;
+
+    uint64_t hits = s_engine.getQueryCacheHits();
+    uint64_t misses = s_engine.getQueryCacheMisses();
+    double hit_rate = hits + misses == 0 ? 0.0 : static_cast<double>(hits) / (hits + misses);
+    resp.setBody(fmt::format("{{\"reload_count\":{},\"query_cache_hits\":{},\"query_cache_misses\":{},\"query_cache_hit_rate\":{:.4f}}}",
+                             s_engine.getReloadCount(), hits, misses, hit_rate), "application/json");
+}
+
+// 在单独的线程中等待SIGHUP并触发重新加载，需要在创建其他线程之前屏蔽SIGHUP
+void startReloadSignalThread(bs_search_engine::SearchEngine& s_engine, sigset_t set)
+{
+    std::thread([&s_engine, set]()
+                {
+        while (true)
+        {
+            int sig = 0;
+            if (sigwait(&set, &sig) == 0 && sig == SIGHUP)
+            {
+                LOG(Level::Info, "收到SIGHUP，重新加载索引");
+                s_engine.requestReload();
+            }
+        } })
+        .detach();
 }
 
 int main(int argc, char* argv[])
 {
-    if(argc != 2)
+    // 所有线程屏蔽SIGHUP，统一由重新加载线程处理，必须在创建任何线程（包括日志线程）之前设置
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+
+    // 日志交给后台线程写出，并限制单个调用点的输出频率，防止日志拖慢事件循环
+    ENABLE_ASYNC_LOG();
+    SET_LOG_RATE_LIMIT(100);
+
+    // 用法：./server 端口 [索引分片数]
+    if(argc != 2 && argc != 3)
     {
         LOG(Level::Error, "启动方式错误");
         return 1;
@@ -38,9 +157,16 @@ int main(int argc, char* argv[])
     // 设置网页根路径
     bs_http_server::HttpServer server(std::stoi(argv[1]));
     server.setBaseDir(bs_public_data::root_path);    
-    bs_search_engine::SearchEngine s_engine;
+    size_t shard_num = argc == 3 ? std::stoul(argv[2]) : 1;
+    bs_search_engine::SearchEngine s_engine(bs_public_data::g_rawfile_path, shard_num);
 
     server.setGetHandler("/search", std::bind(run, std::ref(s_engine), std::placeholders::_1, std::placeholders::_2));
+    server.setGetHandler("/suggest", std::bind(suggest, std::ref(s_engine), std::placeholders::_1, std::placeholders::_2));
+    server.setGetHandler("/facets", std::bind(facets, std::ref(s_engine), std::placeholders::_1, std::placeholders::_2));
+    // 重新加载索引：本机发起POST /admin/reload 或者 kill -HUP
+    server.setPostHandler("/admin/reload", std::bind(reload, std::ref(s_engine), std::placeholders::_1, std::placeholders::_2));
+    server.setGetHandler("/admin/stats", std::bind(stats, std::ref(s_engine), std::placeholders::_1, std::placeholders::_2));
+    startReloadSignalThread(s_engine, set);
 
     int port = std::stoi(argv[1]);
 
@@ -2,143 +2,156 @@
 #define __bs_buffer_h__
 
 #include <vector>
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <cassert>
 #include <string>
+#include <sys/uio.h>
+#include <boost_search/net/memory_pool.h>
 
 namespace bs_buffer
 {
+    // 首个数据块容量，大部分HTTP请求可以放在一个小块中
+    const size_t small_block_size = 4 * 1024 - sizeof(bs_memory_pool::BlockHeader);
+    // 后续数据块容量
+    const size_t large_block_size = 16 * 1024 - sizeof(bs_memory_pool::BlockHeader);
+
+    /**
+     * 链式缓冲区，数据存放在若干个从当前线程内存池中申请的固定大小数据块中
+     * 1. 写入时只在尾部追加数据块，已有数据不会被挪动或者重新分配
+     * 2. 读取完毕的数据块立即归还内存池，长连接空闲时不再占用内存
+     * 3. 提供iovec接口，便于直接使用readv/writev类接口收发数据
+     */
     class Buffer
     {
-        // 缓冲区默认大小
-        const int default_size = 1024;
+        // 数据块
+        struct Block
+        {
+            char *data;
+            size_t capacity;
+            size_t read_idx;  // 读取起始位置（闭）
+            size_t write_idx; // 写入起始位置（闭）
+        };
 
     public:
         Buffer()
-            : read_idx_(0), write_idx_(0), buffer_(default_size)
-        {
-        }
-
-        // 获取第一个元素所在的位置
-        char *getStartPos()
-        {
-            return &(*buffer_.begin());
-        }
-
-        // 获取写位置
-        char *getReadPos()
-        {
-            char *start = getStartPos();
-            return start + read_idx_;
-        }
-
-        // 获取读位置
-        char *getWritePos()
+            : head_(0), readable_size_(0)
         {
-            char *start = getStartPos();
-            return start + write_idx_;
         }
 
-        // 获取第一个元素所在的位置
-        const char *getStartPos() const
+        Buffer(const Buffer &other)
+            : head_(0), readable_size_(0)
         {
-            return &(*buffer_.begin());
+            write_move(other);
         }
 
-        // 获取写位置
-        const char *getReadPos() const
+        Buffer(Buffer &&other) noexcept
+            : blocks_(std::move(other.blocks_)), head_(other.head_), readable_size_(other.readable_size_)
         {
-            const char *start = getStartPos();
-            return start + read_idx_;
+            other.blocks_.clear();
+            other.head_ = 0;
+            other.readable_size_ = 0;
         }
 
-        // 获取读位置
-        const char *getWritePos() const
+        Buffer &operator=(const Buffer &other)
         {
-            const char *start = getStartPos();
-            return start + write_idx_;
+            if (this != &other)
+            {
+                clear();
+                write_move(other);
+            }
+            return *this;
         }
 
-        // 获取当前写位置之后可写空间
-        uint64_t getBackWritableSize()
+        Buffer &operator=(Buffer &&other) noexcept
         {
-            // 左闭右开
-            return buffer_.size() - write_idx_;
+            if (this != &other)
+            {
+                clear();
+                blocks_.swap(other.blocks_);
+                head_ = other.head_;
+                readable_size_ = other.readable_size_;
+                other.head_ = 0;
+                other.readable_size_ = 0;
+            }
+            return *this;
         }
 
-        // 获取当前读位置之前可写空间
-        uint64_t getFrontWritableSize()
+        ~Buffer()
         {
-            return read_idx_;
+            clear();
         }
 
         // 获取可读数据大小
         uint64_t getReadableSize() const
         {
-            return write_idx_ - read_idx_;
-        }
-
-        // 写任意数据——不移动写入指针
-        // 将data数据写入指定长度到缓冲区中
-        void write_noMove(void *data, size_t len)
-        {
-            if (len == 0)
-                return;
-            // 1. 确保空间足够
-            setEnoughSpace(len);
-            const char *data1 = static_cast<const char *>(data);
-            // 2. 写入数据
-            std::copy(data1, data1 + len, getWritePos());
+            return readable_size_;
         }
 
         // 写任意数据——移动写入指针
-        void write_move(void *data, size_t len)
+        void write_move(const void *data, size_t len)
         {
-            write_noMove(data, len);
-            moveWritePtr(len);
-        }
-
-        // 写入字符串数据——不移动写入指针
-        void write_noMove(const std::string &data, size_t len)
-        {
-            char *data1 = const_cast<char *>(data.c_str());
-            write_noMove(data1, len);
+            const char *src = static_cast<const char *>(data);
+            while (len > 0)
+            {
+                Block &tail = getWritableBlock();
+                size_t n = std::min(len, tail.capacity - tail.write_idx);
+                std::memcpy(tail.data + tail.write_idx, src, n);
+                tail.write_idx += n;
+                readable_size_ += n;
+                src += n;
+                len -= n;
+            }
         }
 
         // 写入字符串数据——移动写入指针
         void write_move(const std::string &data, size_t len)
         {
-            char *data1 = const_cast<char *>(data.c_str());
-            write_move(data1, len);
+            write_move(data.data(), len);
         }
 
-        // 写入其他缓冲区的数据——不移动写入指针
-        void write_noMove(const Buffer &data)
+        // 写入其他缓冲区的数据——移动写入指针
+        void write_move(const Buffer &data)
         {
-            write_noMove((void *)(data.getReadPos()), data.getReadableSize());
+            for (size_t i = data.head_; i < data.blocks_.size(); i++)
+            {
+                const Block &b = data.blocks_[i];
+                write_move(b.data + b.read_idx, b.write_idx - b.read_idx);
+            }
         }
 
-        // 写入其他缓冲区的数据——移动写入指针
-        void write_move(const Buffer &data)
+        // 转移其他缓冲区的所有数据块，不拷贝数据
+        void appendBlocks(Buffer &data)
         {
-            write_move((void *)(data.getReadPos()), data.getReadableSize());
+            for (size_t i = data.head_; i < data.blocks_.size(); i++)
+                blocks_.push_back(data.blocks_[i]);
+            readable_size_ += data.readable_size_;
+
+            data.blocks_.clear();
+            data.head_ = 0;
+            data.readable_size_ = 0;
         }
 
         // 读取任意数据——不移动指针
         // 从缓冲区读取指定长度数据到输出参数buf中
-        void read_noMove(void *buf, size_t len)
+        void read_noMove(void *buf, size_t len) const
         {
             // 处理空指针
             if (!buf)
                 return;
-            // 1. 确保要求的长度小于可读空间大小
-            uint64_t readable_size = getReadableSize();
-            assert(len <= readable_size);
-
-            // 2. 将指定长度数据拷贝到输出参数中
-            char *buf1 = static_cast<char *>(buf);
-            char *start = getReadPos();
-            std::copy(start, start + len, buf1);
+            // 确保要求的长度小于可读空间大小
+            assert(len <= readable_size_);
+
+            char *dst = static_cast<char *>(buf);
+            for (size_t i = head_; i < blocks_.size() && len > 0; i++)
+            {
+                const Block &b = blocks_[i];
+                size_t n = std::min(len, b.write_idx - b.read_idx);
+                std::memcpy(dst, b.data + b.read_idx, n);
+                dst += n;
+                len -= n;
+            }
         }
 
         // 读取任意数据——移动指针
@@ -149,7 +162,7 @@ namespace bs_buffer
         }
 
         // 读取数据存入字符串——不移动指针
-        void read_noMove(std::string &buf, size_t len)
+        void read_noMove(std::string &buf, size_t len) const
         {
             // 确保字符串有足够的空间
             buf.resize(len);
@@ -164,43 +177,23 @@ namespace bs_buffer
             read_move(&(buf[0]), len);
         }
 
-        // 查找\r\n
-        uint64_t getCRLF_1(std::string &buf)
-        {
-            return buf.find("\r\n");
-        }
-
-        // 查找\n
-        uint64_t getCRLF_2(std::string &buf)
-        {
-            return buf.find("\n");
-        }
-
         // 读取一行数据（存入字符串，会保存换行符）——不移动指针
-        void readLine_noMove(std::string &buf)
+        // 以\n作为行结束标记，\r\n结尾的行会一并保留\r
+        void readLine_noMove(std::string &buf) const
         {
-            // 基于可读部分创建临时字符串
-            std::string readable_data(getReadPos(), getReadPos() + getReadableSize());
-            // 先获取\r\n，找不到再获取\n
-            uint64_t pos = getCRLF_1(readable_data);
-
-            if (pos != std::string::npos)
-            {
-                // 确保不会越界
-                if (pos + 2 <= getReadableSize())
-                {
-                    std::string str(getReadPos(), getReadPos() + pos + 2);
-                    buf = str;
-                }
-            }
-            else
+            size_t offset = 0;
+            for (size_t i = head_; i < blocks_.size(); i++)
             {
-                pos = getCRLF_2(readable_data);
-                if (pos != std::string::npos && pos + 1 <= getReadableSize())
+                const Block &b = blocks_[i];
+                const char *start = b.data + b.read_idx;
+                size_t size = b.write_idx - b.read_idx;
+                const char *pos = static_cast<const char *>(std::memchr(start, '\n', size));
+                if (pos)
                 {
-                    std::string str(getReadPos(), getReadPos() + pos + 1);
-                    buf = str;
+                    read_noMove(buf, offset + (pos - start) + 1);
+                    return;
                 }
+                offset += size;
             }
         }
 
@@ -211,65 +204,110 @@ namespace bs_buffer
             moveReadPtr(buf.size());
         }
 
-        // 确定是否存在指定空间大小
-        void setEnoughSpace(uint64_t len)
+        // 偏移读取指针，读取完毕的数据块归还内存池
+        void moveReadPtr(size_t len)
         {
-            // 三种情况：
-            // 1. 需要的空间大小小于写位置之后的空间大小，说明空间足够，函数不进行任何行为
-            // 2. 否则，需要的空间大小小于写位置之后的空间大小与读位置之前的空间大小，说明需要挪动已有的数据到空间起始位置
-            // 3. 否则，需要进行扩容，但不进行数据挪动
-            uint64_t back_size = getBackWritableSize();
-            uint64_t front_size = getFrontWritableSize();
-
-            if (len <= back_size)
+            if (len == 0)
                 return;
-            else if (len <= back_size + front_size)
-            {
-                char *start_pos = getReadPos();
-                // 挪动数据
-                uint64_t readable_size = getReadableSize();
-                std::copy(start_pos, start_pos + readable_size, getStartPos());
-                // 重置索引
-                read_idx_ = 0;
-                write_idx_ = readable_size;
-            }
-            else
+            assert(len <= readable_size_);
+            readable_size_ -= len;
+
+            while (len > 0)
             {
-                // 从写位置开始计算，此时写位置就代表当前已经占用的空间大小
-                buffer_.resize(write_idx_ + len);
+                Block &b = blocks_[head_];
+                size_t n = std::min(len, b.write_idx - b.read_idx);
+                b.read_idx += n;
+                len -= n;
+                if (b.read_idx == b.write_idx)
+                    releaseHeadBlock();
             }
+
+            // 没有数据时归还所有数据块
+            if (readable_size_ == 0)
+                clear();
         }
 
-        // 偏移读取指针
-        void moveReadPtr(size_t len)
+        // 获取尾部可写空间，用于直接接收数据，写入后需要调用moveWritePtr
+        void getWritableIovec(struct iovec &iov)
+        {
+            Block &tail = getWritableBlock();
+            iov.iov_base = tail.data + tail.write_idx;
+            iov.iov_len = tail.capacity - tail.write_idx;
+        }
+
+        // 偏移写入指针，长度不能超过getWritableIovec返回的空间
+        void moveWritePtr(size_t len)
         {
             if (len == 0)
                 return;
-            assert(len <= getReadableSize());
-            read_idx_ += len;
+            Block &tail = blocks_.back();
+            // 确保移动后不会超出数据块边界
+            assert(tail.write_idx + len <= tail.capacity);
+            tail.write_idx += len;
+            readable_size_ += len;
         }
 
-        // 偏移写入指针
-        void moveWritePtr(size_t len)
+        // 获取可读数据对应的iovec数组，返回填充的个数
+        int getReadableIovec(struct iovec *iov, int max_cnt) const
         {
-            // 确保移动后不会超出buffer边界
-            assert(write_idx_ + len <= buffer_.size());
-            write_idx_ += len;
+            int cnt = 0;
+            for (size_t i = head_; i < blocks_.size() && cnt < max_cnt; i++)
+            {
+                const Block &b = blocks_[i];
+                if (b.write_idx == b.read_idx)
+                    continue;
+                iov[cnt].iov_base = b.data + b.read_idx;
+                iov[cnt].iov_len = b.write_idx - b.read_idx;
+                cnt++;
+            }
+            return cnt;
         }
 
-        // 清理缓冲区
-        // 更新位置标记为0即可
+        // 清理缓冲区，所有数据块归还内存池
         void clear()
         {
-            read_idx_ = 0;
-            write_idx_ = 0;
+            for (size_t i = head_; i < blocks_.size(); i++)
+                bs_memory_pool::ThreadCache::deallocate(blocks_[i].data);
+            blocks_.clear();
+            head_ = 0;
+            readable_size_ = 0;
+        }
+
+    private:
+        // 获取尾部有剩余空间的数据块，不存在时申请新的数据块
+        Block &getWritableBlock()
+        {
+            if (head_ < blocks_.size() && blocks_.back().write_idx < blocks_.back().capacity)
+                return blocks_.back();
+
+            // 已经读取完毕的数据块占据的位置在追加前统一清理
+            if (head_ > 0)
+            {
+                blocks_.erase(blocks_.begin(), blocks_.begin() + head_);
+                head_ = 0;
+            }
+
+            size_t capacity = blocks_.empty() ? small_block_size : large_block_size;
+            Block b;
+            b.data = static_cast<char *>(bs_memory_pool::ThreadCache::local().allocate(capacity));
+            b.capacity = capacity;
+            b.read_idx = 0;
+            b.write_idx = 0;
+            blocks_.push_back(b);
+            return blocks_.back();
+        }
+
+        void releaseHeadBlock()
+        {
+            bs_memory_pool::ThreadCache::deallocate(blocks_[head_].data);
+            head_++;
         }
 
     private:
-        std::vector<char> buffer_;
-        uint64_t read_idx_;  // 读取起始位置（闭）
-        uint64_t write_idx_; // 写入起始位置（闭）
+        std::vector<Block, bs_memory_pool::PoolAllocator<Block>> blocks_; // 数据块，head_之前的数据块已经归还
+        size_t head_;                                                     // 第一个有效数据块下标
+        uint64_t readable_size_;                                          // 可读数据总大小
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -4,6 +4,7 @@
 #include <any>
 #include <boost_search/base/log.h>
 #include <boost_search/net/buffer.h>
+#include <boost_search/net/memory_pool.h>
 #include <boost_search/net/socket.h>
 #include <boost_search/net/event_loop_lock_queue.h>
 
@@ -20,6 +21,9 @@ namespace bs_connection
         Connecting     // 连接建立中
     };
 
+    // 单次发送最多聚集的数据块个数
+    const int max_send_iov = 64;
+
     class Connection : public std::enable_shared_from_this<Connection>
     {
     public:
@@ -34,7 +38,7 @@ namespace bs_connection
         using anyEventCallback_t = std::function<void(const Connection::ptr &)>;
 
         Connection(bs_event_loop_lock_queue::EventLoopLockQueue *loop, const std::string &id, int fd)
-            : fd_(fd), id_(id), event_loop_(loop), socket_(std::make_shared<bs_socket::Socket>(fd)), channel_(std::make_shared<bs_channel::Channel>(event_loop_, fd_)), con_status_(ConnectionStatus::Connecting), enable_timeout_release_(false)
+            : fd_(fd), id_(id), event_loop_(loop), socket_(bs_memory_pool::makeShared<bs_socket::Socket>(fd)), channel_(bs_memory_pool::makeShared<bs_channel::Channel>(event_loop_, fd_)), con_status_(ConnectionStatus::Connecting), enable_timeout_release_(false)
         {
             // 设置回调给Channel，但是不启动读事件监控，确保定时任务可以正常使用
             // 防止出现定时任务没有启动之前有读事件发生，此时不存在定时任务导致错误刷新任务
@@ -59,6 +63,12 @@ namespace bs_connection
              */
             bs_buffer::Buffer buffer;
             buffer.write_move(data, len);
+            send(std::move(buffer));
+        }
+
+        // 发送已经写好的缓冲区，数据块直接转移到输出缓冲区，不再拷贝数据
+        void send(bs_buffer::Buffer &&buffer)
+        {
             event_loop_->runTasks(std::bind(&Connection::sendInLoop, this, std::move(buffer)));
         }
 
@@ -124,6 +134,20 @@ namespace bs_connection
             return id_;
         }
 
+        // 对端IP地址，第一次获取后缓存
+        const std::string &getPeerIp()
+        {
+            if (peer_ip_.empty())
+                peer_ip_ = socket_->getPeerIp();
+            return peer_ip_;
+        }
+
+        // 连接所属的EventLoop
+        bs_event_loop_lock_queue::EventLoopLockQueue *getEventLoop()
+        {
+            return event_loop_;
+        }
+
         std::any &getContext()
         {
             return context_;
@@ -154,7 +178,8 @@ namespace bs_connection
             // 如果连接是待关闭状态就不再发送数据
             if (con_status_ == ConnectionStatus::Disconnected)
                 return;
-            out_buffer_.write_move(buffer);
+            // 直接转移数据块，不再拷贝数据
+            out_buffer_.appendBlocks(buffer);
             if (!channel_->checkIsConcerningWriteFd())
                 channel_->enableConcerningWriteFd();
         }
@@ -242,10 +267,15 @@ namespace bs_connection
                 con_status_ == ConnectionStatus::Disconnecting)
                 return;
 
-            char buffer[65536] = {0};
             // 读取数据并放入到输入缓冲区中
             // 再将输入缓冲区中的数据交给消息回调处理
-            ssize_t ret = socket_->recv_nonBlock(buffer, 65535);
+            // 优先直接读入输入缓冲区尾部的数据块，剩余数据先放入栈上空间再追加
+            char extra[65536];
+            struct iovec iov[2];
+            in_buffer_.getWritableIovec(iov[0]);
+            iov[1].iov_base = extra;
+            iov[1].iov_len = sizeof(extra);
+            ssize_t ret = socket_->recvv_nonBlock(iov, 2);
             if (ret < 0)
             {
                 // 释放资源后关闭连接
@@ -258,7 +288,9 @@ namespace bs_connection
 
             // 写入数据到输入缓冲区
             // 读取为0依旧当做有数据处理，只是写入的数据大小为0
-            in_buffer_.write_move(buffer, ret);
+            size_t direct = std::min(static_cast<size_t>(ret), iov[0].iov_len);
+            in_buffer_.moveWritePtr(direct);
+            in_buffer_.write_move(extra, ret - direct);
             if (in_buffer_.getReadableSize() > 0)
                 if (msg_cb_)
                     msg_cb_(shared_from_this(), in_buffer_);
@@ -271,8 +303,10 @@ namespace bs_connection
             if (con_status_ == ConnectionStatus::Disconnected)
                 return;
 
-            // 将输出缓冲区中的数据进行发送
-            ssize_t ret = socket_->send_nonBlock(out_buffer_.getReadPos(), out_buffer_.getReadableSize());
+            // 将输出缓冲区中的数据块一次性发送
+            struct iovec iov[max_send_iov];
+            int cnt = out_buffer_.getReadableIovec(iov, max_send_iov);
+            ssize_t ret = socket_->sendv_nonBlock(iov, cnt);
             if (ret < 0)
             {
                 // 判断输入缓冲区是否还有数据需要处理
@@ -281,6 +315,7 @@ namespace bs_connection
                         msg_cb_(shared_from_this(), in_buffer_);
                 // 处理完毕后直接释放连接
                 release();
+                return;
             }
             // 移动读指针
             out_buffer_.moveReadPtr(ret);
@@ -341,6 +376,7 @@ namespace bs_connection
         std::any context_;                                         // 协议上下文管理
         ConnectionStatus con_status_;                              // 连接状态
         bool enable_timeout_release_;                              // 连接超时释放标记
+        std::string peer_ip_;                                      // 对端IP地址
 
         connectedCallback_t con_cb_;
         messageCallback_t msg_cb_;
@@ -62,13 +62,30 @@ namespace bs_event_loop_lock_queue
             // 否则插入到任务队列
             enqueue(task);
         }
+
+        // 转移任务本身，调用线程不保留任务及其捕获对象的副本
+        void runTasks(task_t &&task)
+        {
+            if(isInCurrentThread())
+            {
+                task();
+                return;
+            }
+
+            enqueue(std::move(task));
+        }
         
         void enqueue(const task_t &task)
+        {
+            enqueue(task_t(task));
+        }
+
+        void enqueue(task_t &&task)
         {
             // 任务入队列
             {
                 std::unique_lock<std::mutex> lock(tasks_mutex_);
-                tasks_.emplace_back(task);
+                tasks_.emplace_back(std::move(task));
             }
 
             // 防止执行流阻塞在epoll_wait，使用时间事件通知的方式触发可读事件跳出epoll_wait
@@ -285,9 +285,9 @@ namespace bs_http_context
 
             // 否则当前缓冲区的数据就是小于需要的剩余长度，获取缓冲区所有数据放入请求体
             std::string &body = request_.getBody();
-            std::string out;
-            body.append(buf.getReadPos(), buf.getReadableSize());
-            buf.moveReadPtr(buf.getReadableSize());
+            size_t old_size = body.size();
+            body.resize(old_size + buf.getReadableSize());
+            buf.read_move(&body[old_size], buf.getReadableSize());
             // 此时不需要更新状态，因为还需要后续继续读取内容放入请求体
             return true;
         }
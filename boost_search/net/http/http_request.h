@@ -76,6 +76,7 @@ namespace bs_http_request
             body_.clear();
             headers_.clear();
             params_.clear();
+            peer_ip_.clear();
         }
 
         size_t getContentLength()
@@ -129,6 +130,17 @@ namespace bs_http_request
             return body_;
         }
 
+        void setPeerIp(const std::string &ip)
+        {
+            peer_ip_ = ip;
+        }
+
+        // 发起请求的客户端IP地址
+        const std::string &getPeerIp()
+        {
+            return peer_ip_;
+        }
+
     private:
         std::string method_;                                   // 请求方法
         std::filesystem::path path_;                           // 请求资源路径
@@ -136,6 +148,7 @@ namespace bs_http_request
         std::unordered_map<std::string, std::string> headers_; // 请求头
         std::unordered_map<std::string, std::string> params_;  // 请求参数
         std::string body_;                                     // 请求体
+        std::string peer_ip_;                                  // 客户端IP地址
     };
 }
 
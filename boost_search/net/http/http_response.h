@@ -3,7 +3,6 @@
 
 #include <string>
 #include <unordered_map>
-#include <sstream>
 #include <boost_search/net/http/http_request.h>
 #include <boost_search/utils/info_get.h>
 
@@ -40,8 +39,15 @@ namespace bs_http_response
             setHeader("Content-Type", type);
         }
 
+        // 设置响应正文，转移body的内容，用于较大的正文（例如搜索结果）
+        void setBody(std::string &&body, const std::string &type = "text/html")
+        {
+            body_ = std::move(body);
+            setHeader("Content-Type", type);
+        }
+
         // 获取响应正文
-        std::string getBody()
+        const std::string &getBody() const
         {
             return body_;
         }
@@ -110,22 +116,40 @@ namespace bs_http_response
         }
 
         std::string constructHttpResponseStr(bs_http_request::HttpRequest &req)
+        {
+            // 构建响应行和响应头
+            std::string resp_str = constructHttpResponseHead(req);
+
+            // 构建响应体
+            resp_str += body_;
+
+            return resp_str;
+        }
+
+        // 构建响应行和响应头（包括结尾的空行），不包括响应体
+        std::string constructHttpResponseHead(bs_http_request::HttpRequest &req)
         {
             // 构建响应行
-            std::stringstream resp_str;
-            resp_str << req.getVersion() << " " << std::to_string(status_) << " " << bs_info_get::InfoGet::getStatusDesc(status_) << "\r\n";
+            std::string head;
+            head += req.getVersion();
+            head += ' ';
+            head += std::to_string(status_);
+            head += ' ';
+            head += bs_info_get::InfoGet::getStatusDesc(status_);
+            head += "\r\n";
 
             // 构建响应头
-            std::for_each(headers_.begin(), headers_.end(), [&](const std::pair<std::string, std::string> &p){
-                resp_str << p.first << ": " << p.second << "\r\n";
-            });
-
-            resp_str << "\r\n";
+            for (const auto &p : headers_)
+            {
+                head += p.first;
+                head += ": ";
+                head += p.second;
+                head += "\r\n";
+            }
 
-            // 构建响应体
-            resp_str << body_;
+            head += "\r\n";
 
-            return resp_str.str();
+            return head;
         }
     private:
         int status_; // 响应状态码
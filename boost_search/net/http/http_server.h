@@ -171,10 +171,14 @@ namespace bs_http_server
 
 
 
-            std::string resp_str = resp.constructHttpResponseStr(req);
+            // 响应头和响应体依次写入同一个缓冲区后整体转移给连接，响应体只拷贝一次
+            std::string head = resp.constructHttpResponseHead(req);
+            bs_buffer::Buffer buffer;
+            buffer.write_move(head.data(), head.size());
+            buffer.write_move(resp.getBody().data(), resp.getBody().size());
 
             // 发送响应
-            con->send((void *)(resp_str.c_str()), resp_str.size());
+            con->send(std::move(buffer));
         }
 
         // 判断是否是静态资源请求
@@ -282,6 +286,7 @@ namespace bs_http_server
 
                 if (context->getRecvStatus() != bs_http_context::ReqRecvStatus::RecvOk)
                     return; // 未拿到一个完整的HTTP请求
+                req.setPeerIp(con->getPeerIp());
                 getMapping(req, resp);
                 // 根据HttpResponse组织HTTP响应字符串
                 // 如果是404响应，就构造一个404响应对象
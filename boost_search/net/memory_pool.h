@@ -0,0 +1,210 @@
+#ifndef __bs_memory_pool_h__
+#define __bs_memory_pool_h__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace bs_memory_pool
+{
+    /**
+     * 线程级内存池，每个事件循环线程持有一个ThreadCache
+     * 1. 按照2的幂划分大小类别，同类别的空闲块通过单链表管理
+     * 2. 新的内存块从整块slab中切分，释放后不归还系统而是放回所属线程的空闲链表
+     * 3. 在其他线程释放的块放入所属线程的远端释放栈，由所属线程下一次申请时统一回收
+     * 这样连接对象和缓冲区可以在所属线程内反复复用，避免多个线程同时竞争malloc
+     */
+
+    // 最小块大小（包含块头）
+    const size_t min_block_shift = 5; // 32B
+    // 最大块大小（包含块头），超过的申请直接交给系统分配
+    const size_t max_block_shift = 16; // 64KiB
+    // 大小类别个数
+    const size_t size_class_num = max_block_shift - min_block_shift + 1;
+    // 每次向系统申请的slab大小
+    const size_t slab_size = 256 * 1024;
+
+    class ThreadCache;
+
+    // 块头，保存块所属的线程缓存和大小类别，保证用户数据16字节对齐
+    struct alignas(16) BlockHeader
+    {
+        ThreadCache *owner; // 为空表示直接由系统分配
+        size_t size_class;
+    };
+
+    // 空闲块节点，复用块的用户数据区
+    struct FreeNode
+    {
+        FreeNode *next;
+    };
+
+    class ThreadCache
+    {
+    public:
+        ThreadCache()
+        {
+            for (size_t i = 0; i < size_class_num; i++)
+            {
+                free_lists_[i] = nullptr;
+                remote_frees_[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        // 禁用拷贝，线程缓存地址会被写入每一个块头
+        ThreadCache(const ThreadCache &) = delete;
+        ThreadCache &operator=(const ThreadCache &) = delete;
+
+        // 获取当前线程的缓存
+        // 线程缓存与线程同生命周期且不释放，防止其他线程归还内存时访问到已经销毁的对象
+        static ThreadCache &local()
+        {
+            thread_local ThreadCache *cache = new ThreadCache();
+            return *cache;
+        }
+
+        void *allocate(size_t size)
+        {
+            size_t cls = getSizeClass(size + sizeof(BlockHeader));
+            if (cls >= size_class_num)
+            {
+                // 大块直接交给系统
+                BlockHeader *h = static_cast<BlockHeader *>(::operator new(size + sizeof(BlockHeader)));
+                h->owner = nullptr;
+                h->size_class = cls;
+                return h + 1;
+            }
+
+            FreeNode *node = free_lists_[cls];
+            // 本地链表为空时先回收其他线程归还的块，再从slab中切分
+            if (!node)
+            {
+                node = remote_frees_[cls].exchange(nullptr, std::memory_order_acquire);
+                if (!node)
+                    node = carveFromSlab(cls);
+            }
+            free_lists_[cls] = node->next;
+
+            BlockHeader *h = reinterpret_cast<BlockHeader *>(node);
+            h->owner = this;
+            h->size_class = cls;
+            return h + 1;
+        }
+
+        static void deallocate(void *p)
+        {
+            if (!p)
+                return;
+
+            BlockHeader *h = static_cast<BlockHeader *>(p) - 1;
+            ThreadCache *owner = h->owner;
+            if (!owner)
+            {
+                ::operator delete(h);
+                return;
+            }
+
+            size_t cls = h->size_class;
+            FreeNode *node = reinterpret_cast<FreeNode *>(h);
+            if (owner == &local())
+            {
+                // 所属线程内释放，直接放回空闲链表
+                node->next = owner->free_lists_[cls];
+                owner->free_lists_[cls] = node;
+                return;
+            }
+
+            // 其他线程释放，压入所属线程的远端释放栈
+            FreeNode *head = owner->remote_frees_[cls].load(std::memory_order_relaxed);
+            do
+            {
+                node->next = head;
+            } while (!owner->remote_frees_[cls].compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+    private:
+        // 计算包含块头后的大小类别
+        static size_t getSizeClass(size_t size)
+        {
+            size_t shift = min_block_shift;
+            while ((static_cast<size_t>(1) << shift) < size)
+                shift++;
+            return shift - min_block_shift;
+        }
+
+        // 从新的slab中切分出一批空闲块，返回链表头
+        FreeNode *carveFromSlab(size_t cls)
+        {
+            size_t block_size = static_cast<size_t>(1) << (cls + min_block_shift);
+            size_t size = block_size > slab_size ? block_size : slab_size;
+            char *slab = static_cast<char *>(::operator new(size));
+            slabs_.push_back(slab);
+
+            FreeNode *head = nullptr;
+            for (size_t off = size; off >= block_size; off -= block_size)
+            {
+                FreeNode *node = reinterpret_cast<FreeNode *>(slab + off - block_size);
+                node->next = head;
+                head = node;
+            }
+
+            return head;
+        }
+
+    private:
+        FreeNode *free_lists_[size_class_num];                  // 本线程的空闲链表
+        std::atomic<FreeNode *> remote_frees_[size_class_num]; // 其他线程归还的空闲块
+        std::vector<char *> slabs_;                             // 已经申请的slab
+    };
+
+    // 基于线程缓存的分配器，可用于std::allocate_shared和标准容器
+    template <class T>
+    class PoolAllocator
+    {
+    public:
+        using value_type = T;
+
+        PoolAllocator() noexcept = default;
+
+        template <class U>
+        PoolAllocator(const PoolAllocator<U> &) noexcept
+        {
+        }
+
+        T *allocate(size_t n)
+        {
+            return static_cast<T *>(ThreadCache::local().allocate(n * sizeof(T)));
+        }
+
+        void deallocate(T *p, size_t)
+        {
+            ThreadCache::deallocate(p);
+        }
+
+        template <class U>
+        bool operator==(const PoolAllocator<U> &) const noexcept
+        {
+            return true;
+        }
+
+        template <class U>
+        bool operator!=(const PoolAllocator<U> &) const noexcept
+        {
+            return false;
+        }
+    };
+
+    // 从当前线程的内存池中创建共享对象
+    template <class T, class... Args>
+    std::shared_ptr<T> makeShared(Args &&...args)
+    {
+        return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+    }
+}
+
+#endif
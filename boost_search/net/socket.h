@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <string>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <boost_search/base/log.h>
@@ -163,6 +164,51 @@ namespace bs_socket
             return recv_block(buf, len, MSG_DONTWAIT);
         }
 
+        // 分散接收，返回值含义与recv_block一致
+        ssize_t recvv_nonBlock(struct iovec *iov, int cnt)
+        {
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = cnt;
+            ssize_t ret = recvmsg(sockfd_, &msg, MSG_DONTWAIT);
+            if (ret < 0)
+            {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                    return 0;
+                LOG(Level::Error, "接收失败");
+                return -1;
+            }
+            else if (ret == 0)
+            {
+                // 对端正常关闭连接
+                return -1;
+            }
+
+            return ret;
+        }
+
+        // 聚集发送，返回值含义与send_block一致
+        ssize_t sendv_nonBlock(struct iovec *iov, int cnt)
+        {
+            if (cnt == 0)
+                return 0;
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = cnt;
+            ssize_t ret = sendmsg(sockfd_, &msg, MSG_DONTWAIT);
+            if (ret < 0)
+            {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                    return 0;
+                LOG(Level::Error, "发送失败");
+                return -1;
+            }
+
+            return ret;
+        }
+
         // 关闭套接字
         void close()
         {
@@ -227,6 +273,22 @@ namespace bs_socket
             close();
         }
 
+        // 获取对端IP地址，失败时返回空字符串
+        std::string getPeerIp()
+        {
+            struct sockaddr_in addr;
+            socklen_t len = sizeof(addr);
+            if (::getpeername(sockfd_, reinterpret_cast<struct sockaddr *>(&addr), &len) < 0)
+            {
+                LOG(Level::Warning, "获取对端地址失败：{}", strerror(errno));
+                return "";
+            }
+
+            char ip[INET_ADDRSTRLEN] = {0};
+            ::inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+            return ip;
+        }
+
     private:
         int sockfd_;
     };
@@ -4,6 +4,7 @@
 #include <unordered_map>
 #include <boost_search/net/acceptor.h>
 #include <boost_search/net/connection.h>
+#include <boost_search/net/memory_pool.h>
 #include <boost_search/net/timing_wheel.h>
 #include <boost_search/base/uuid_generator.h>
 #include <boost_search/net/event_loop_lock_queue.h>
@@ -69,7 +70,15 @@ namespace bs_tcp_server
         {
             // 创建客户端套接字结构
             const std::string id = rs_uuid_generator::UuidGenerator::generate_uuid();
-            bs_connection::Connection::ptr client = std::make_shared<bs_connection::Connection>(loop_pool_->getNextLoop(), id, newfd);
+            // 连接对象（包括其中的Socket和Channel）在所属的从属线程中创建，从该线程的内存池分配
+            bs_event_loop_lock_queue::EventLoopLockQueue *loop = loop_pool_->getNextLoop();
+            loop->runTasks(std::bind(&TcpServer::createConnectionInLoop, this, loop, id, newfd));
+        }
+
+        // 在连接所属的线程中执行
+        void createConnectionInLoop(bs_event_loop_lock_queue::EventLoopLockQueue *loop, const std::string &id, int fd)
+        {
+            bs_connection::Connection::ptr client = bs_memory_pool::makeShared<bs_connection::Connection>(loop, id, fd);
 
             client->enableTimeoutRelease(10);
 
@@ -77,24 +86,35 @@ namespace bs_tcp_server
             client->setMessageCallback(msg_cb_);
             client->setOuterCloseCallback(outer_close_cb_);
             client->setInnerCloseCallback(std::bind(&TcpServer::handleClose, this, std::placeholders::_1));
+
+            // 管理连接的客户端，连接表只在主线程中访问
+            // 先投递登记再启动事件监控：同一线程投递的任务按顺序执行，关闭时的注销一定在登记之后
+            base_loop_->runTasks(std::bind(&TcpServer::addConnectionInLoop, this, client));
             client->establishAfterConnected();
+        }
 
-            // 管理连接的客户端
-            auto pos = conns_.try_emplace(id, client);
+        void addConnectionInLoop(const bs_connection::Connection::ptr &con)
+        {
+            conns_.try_emplace(con->getId(), con);
         }
 
+        // 只传递连接ID，主线程不持有连接的其他引用
         void handleClose(const bs_connection::Connection::ptr &con)
         {
-            base_loop_->runTasks(std::bind(&TcpServer::handleCloseInLoop, this, con));
+            base_loop_->runTasks(std::bind(&TcpServer::handleCloseInLoop, this, con->getId()));
         }
 
-        void handleCloseInLoop(const bs_connection::Connection::ptr &con)
+        void handleCloseInLoop(const std::string &id)
         {
-            std::string id = con->getId();
             auto pos = conns_.find(id);
             if (pos == conns_.end())
                 return;
+            bs_connection::Connection::ptr con = std::move(pos->second);
             conns_.erase(pos);
+
+            // 最后一个引用转移到所属线程的任务中，连接对象在该线程释放，归还到该线程的内存池，不产生跨线程归还
+            bs_event_loop_lock_queue::EventLoopLockQueue *loop = con->getEventLoop();
+            loop->runTasks([con = std::move(con)]() {});
         }
 
         void runTaskInLoop(const bs_schedule_task::ScheduleTask::main_task_t &task, uint32_t timeout)
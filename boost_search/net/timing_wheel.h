@@ -9,6 +9,7 @@
 #include <boost_search/base/error.h>
 #include <boost_search/net/schedule_task.h>
 #include <boost_search/net/channel.h>
+#include <boost_search/net/memory_pool.h>
 
 namespace bs_event_loop_lock_queue
 {
@@ -55,6 +56,19 @@ namespace bs_timing_wheel
             return static_cast<bool>(task_map_.count(id));
         }
 
+        ~TimingWheel()
+        {
+            // 时间轮销毁时不再执行剩余任务，并且需要在task_map_销毁之前释放任务
+            // 否则任务的释放回调会访问已经销毁的task_map_
+            for (auto &pair : task_map_)
+            {
+                per_task_ptr_t pt = pair.second.lock();
+                if (pt)
+                    pt->cancelTask();
+            }
+            schedule_tasks_.clear();
+        }
+
     private:
         // 直接从哈希表中删除对应的任务
         void removeTask(std::string id)
@@ -133,7 +147,7 @@ namespace bs_timing_wheel
         void insertTaskInLoop(const std::string &id, uint32_t timeout, const bs_schedule_task::ScheduleTask::main_task_t &task)
         {
             // 构造任务对象
-            per_task_ptr_t pt(new bs_schedule_task::ScheduleTask(id, timeout, task));
+            per_task_ptr_t pt = bs_memory_pool::makeShared<bs_schedule_task::ScheduleTask>(id, timeout, task);
             pt->setReleaseTask(std::bind(&TimingWheel::removeTask, this, id));
             int pos = (tick_ + timeout) % capacity_;
             schedule_tasks_[pos].push_back(pt);
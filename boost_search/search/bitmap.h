@@ -0,0 +1,258 @@
+#ifndef __bs_bitmap_h__
+#define __bs_bitmap_h__
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+namespace bs_bitmap
+{
+    // 数组容器最多保存的元素数，超过之后转为位图容器，两者占用的内存都不超过8KB
+    const size_t array_container_max = 4096;
+    // 位图容器的64位字数，覆盖低16位的全部取值
+    const size_t bitmap_container_words = 1024;
+
+    /**
+     * 压缩位图（Roaring位图的简化实现），保存32位无符号整数的集合
+     * 1. 按照高16位把整数分到不同的容器中，容器按照高16位递增排列
+     * 2. 容器中元素较少时使用有序的低16位数组，超过array_container_max个元素时使用8KB的位图
+     * 3. 交集只需要比较高16位相同的容器，数组与数组归并、数组与位图逐个测试、位图与位图按字求与再统计
+     * 按照递增顺序添加元素时每次只在末尾追加
+     */
+    class RoaringBitmap
+    {
+        struct Container
+        {
+            std::vector<uint16_t> array; // 数组容器，有序
+            std::vector<uint64_t> bits;  // 位图容器，不为空时使用位图
+            uint32_t cardinality = 0;
+
+            bool isBitmap() const
+            {
+                return !bits.empty();
+            }
+
+            bool contains(uint16_t low) const
+            {
+                if (isBitmap())
+                    return (bits[low >> 6] >> (low & 63)) & 1;
+                return std::binary_search(array.begin(), array.end(), low);
+            }
+
+            void add(uint16_t low)
+            {
+                if (isBitmap())
+                {
+                    uint64_t bit = 1ull << (low & 63);
+                    if (!(bits[low >> 6] & bit))
+                    {
+                        bits[low >> 6] |= bit;
+                        cardinality++;
+                    }
+                    return;
+                }
+
+                if (array.empty() || array.back() < low)
+                    array.push_back(low);
+                else
+                {
+                    auto pos = std::lower_bound(array.begin(), array.end(), low);
+                    if (*pos == low)
+                        return;
+                    array.insert(pos, low);
+                }
+                cardinality++;
+
+                if (array.size() > array_container_max)
+                {
+                    bits.assign(bitmap_container_words, 0);
+                    for (uint16_t v : array)
+                        bits[v >> 6] |= 1ull << (v & 63);
+                    std::vector<uint16_t>().swap(array);
+                }
+            }
+        };
+
+    public:
+        void add(uint32_t x)
+        {
+            uint16_t key = static_cast<uint16_t>(x >> 16);
+            size_t i;
+            if (!keys_.empty() && keys_.back() == key)
+                i = keys_.size() - 1;
+            else
+            {
+                i = std::lower_bound(keys_.begin(), keys_.end(), key) - keys_.begin();
+                if (i == keys_.size() || keys_[i] != key)
+                {
+                    keys_.insert(keys_.begin() + i, key);
+                    containers_.insert(containers_.begin() + i, Container());
+                }
+            }
+            containers_[i].add(static_cast<uint16_t>(x & 0xFFFF));
+        }
+
+        bool contains(uint32_t x) const
+        {
+            uint16_t key = static_cast<uint16_t>(x >> 16);
+            auto pos = std::lower_bound(keys_.begin(), keys_.end(), key);
+            if (pos == keys_.end() || *pos != key)
+                return false;
+            return containers_[pos - keys_.begin()].contains(static_cast<uint16_t>(x & 0xFFFF));
+        }
+
+        uint64_t cardinality() const
+        {
+            uint64_t n = 0;
+            for (const auto &c : containers_)
+                n += c.cardinality;
+            return n;
+        }
+
+        bool empty() const
+        {
+            return containers_.empty();
+        }
+
+        // 与other的交集中的元素数，不生成交集
+        uint64_t andCardinality(const RoaringBitmap &other) const
+        {
+            uint64_t n = 0;
+            size_t i = 0, j = 0;
+            while (i < keys_.size() && j < other.keys_.size())
+            {
+                if (keys_[i] < other.keys_[j])
+                    i++;
+                else if (keys_[i] > other.keys_[j])
+                    j++;
+                else
+                    n += andCardinality(containers_[i++], other.containers_[j++]);
+            }
+            return n;
+        }
+
+        // 按照递增顺序遍历所有元素
+        template <class Func>
+        void forEach(Func &&func) const
+        {
+            for (size_t i = 0; i < keys_.size(); i++)
+            {
+                uint32_t high = static_cast<uint32_t>(keys_[i]) << 16;
+                const Container &c = containers_[i];
+                if (!c.isBitmap())
+                {
+                    for (uint16_t low : c.array)
+                        func(high | low);
+                    continue;
+                }
+                for (size_t w = 0; w < bitmap_container_words; w++)
+                {
+                    uint64_t word = c.bits[w];
+                    while (word)
+                    {
+                        func(high | static_cast<uint32_t>(w * 64 + __builtin_ctzll(word)));
+                        word &= word - 1;
+                    }
+                }
+            }
+        }
+
+        // 对递增的ids中属于集合的元素按顺序调用func(下标)，用于在打分之前求交
+        // ids与容器按照高16位同步推进，数组容器向前查找、位图容器直接测试，不需要逐个元素查找所在的容器
+        template <class Func>
+        void forEachContained(const uint32_t *ids, size_t n, Func &&func) const
+        {
+            size_t i = 0, k = 0;
+            while (i < n && k < keys_.size())
+            {
+                uint16_t key = static_cast<uint16_t>(ids[i] >> 16);
+                if (keys_[k] < key)
+                {
+                    k = std::lower_bound(keys_.begin() + k, keys_.end(), key) - keys_.begin();
+                    continue;
+                }
+                // 跳过高16位不在集合中的元素
+                uint32_t high = static_cast<uint32_t>(keys_[k]) << 16;
+                if (keys_[k] > key)
+                {
+                    i = std::lower_bound(ids + i, ids + n, high) - ids;
+                    continue;
+                }
+
+                const Container &c = containers_[k++];
+                size_t a = 0;
+                for (; i < n && (ids[i] >> 16) == key; i++)
+                {
+                    uint16_t low = static_cast<uint16_t>(ids[i] & 0xFFFF);
+                    if (c.isBitmap())
+                    {
+                        if ((c.bits[low >> 6] >> (low & 63)) & 1)
+                            func(i);
+                        continue;
+                    }
+                    a = std::lower_bound(c.array.begin() + a, c.array.end(), low) - c.array.begin();
+                    if (a < c.array.size() && c.array[a] == low)
+                        func(i);
+                }
+            }
+        }
+
+        size_t memoryBytes() const
+        {
+            size_t n = keys_.capacity() * sizeof(uint16_t) + containers_.capacity() * sizeof(Container);
+            for (const auto &c : containers_)
+                n += c.array.capacity() * sizeof(uint16_t) + c.bits.capacity() * sizeof(uint64_t);
+            return n;
+        }
+
+        void clear()
+        {
+            keys_.clear();
+            containers_.clear();
+        }
+
+    private:
+        static uint64_t andCardinality(const Container &a, const Container &b)
+        {
+            uint64_t n = 0;
+            if (a.isBitmap() && b.isBitmap())
+            {
+                for (size_t w = 0; w < bitmap_container_words; w++)
+                    n += __builtin_popcountll(a.bits[w] & b.bits[w]);
+                return n;
+            }
+            if (a.isBitmap() || b.isBitmap())
+            {
+                const Container &arr = a.isBitmap() ? b : a;
+                const Container &bm = a.isBitmap() ? a : b;
+                for (uint16_t v : arr.array)
+                    n += (bm.bits[v >> 6] >> (v & 63)) & 1;
+                return n;
+            }
+
+            // 两个有序数组归并
+            size_t i = 0, j = 0;
+            while (i < a.array.size() && j < b.array.size())
+            {
+                if (a.array[i] < b.array[j])
+                    i++;
+                else if (a.array[i] > b.array[j])
+                    j++;
+                else
+                {
+                    n++;
+                    i++;
+                    j++;
+                }
+            }
+            return n;
+        }
+
+    private:
+        std::vector<uint16_t> keys_;        // 各个容器对应的高16位，递增
+        std::vector<Container> containers_; // 与keys_一一对应
+    };
+}
+
+#endif
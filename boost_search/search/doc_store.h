@@ -0,0 +1,234 @@
+#ifndef __bs_doc_store_h__
+#define __bs_doc_store_h__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <lz4.h>
+#include <boost_search/base/log.h>
+#include <boost_search/base/lru_cache.h>
+
+namespace bs_doc_store
+{
+    using namespace bs_log_system;
+
+    // 每个压缩块中未压缩正文的目标大小，块越大压缩率越高，摘要时解压一个块的代价也越大
+    const size_t default_block_size = 32 * 1024;
+    // 每个线程缓存的解压块数
+    const size_t block_cache_capacity = 16;
+
+    /**
+     * 正文存储，正文只在截取摘要时使用，不需要一直以明文保存在内存中
+     * 1. 文档正文按照文档ID依次追加到一个未压缩的尾块中，尾块达到default_block_size后整体用LZ4压缩，
+     *    所有压缩块首尾相接存放在一块连续内存中，每个文档只记录所在的块、块内偏移和长度
+     * 2. 读取时解压整个块，解压结果放在线程内的LRU缓存中，同一次搜索的结果通常来自少数几个块
+     * 3. 尾块没有压缩，直接读取；每批文档追加完成后调用seal压缩尾块
+     * 4. 建立完成后只读，多个线程可以同时读取
+     */
+    class BodyStore
+    {
+        // 文档正文的位置
+        struct DocLoc
+        {
+            uint32_t block;  // 所在的块
+            uint32_t offset; // 在解压后的块中的偏移
+            uint32_t size;   // 正文长度
+        };
+
+        // 压缩块的位置
+        struct Block
+        {
+            uint64_t offset;          // 在compressed_中的偏移
+            uint32_t compressed_size; // 压缩后的长度，为0时按照原文保存
+            uint32_t raw_size;        // 解压后的长度
+        };
+
+    public:
+        BodyStore()
+            : store_id_(nextStoreId())
+        {
+        }
+
+        // 复制得到的存储可能继续追加不同的块，使用新的标识，避免与原存储在线程缓存中冲突
+        BodyStore(const BodyStore &other)
+            : docs_(other.docs_), blocks_(other.blocks_), compressed_(other.compressed_), open_(other.open_),
+              raw_bytes_(other.raw_bytes_), store_id_(nextStoreId())
+        {
+        }
+
+        // 移动时转移标识，被移动的存储重新分配标识
+        BodyStore(BodyStore &&other) noexcept
+            : docs_(std::move(other.docs_)), blocks_(std::move(other.blocks_)), compressed_(std::move(other.compressed_)), open_(std::move(other.open_)),
+              raw_bytes_(other.raw_bytes_), store_id_(other.store_id_)
+        {
+            other.clear();
+        }
+
+        BodyStore &operator=(const BodyStore &other)
+        {
+            if (this != &other)
+            {
+                BodyStore temp(other);
+                *this = std::move(temp);
+            }
+            return *this;
+        }
+
+        BodyStore &operator=(BodyStore &&other) noexcept
+        {
+            if (this != &other)
+            {
+                docs_ = std::move(other.docs_);
+                blocks_ = std::move(other.blocks_);
+                compressed_ = std::move(other.compressed_);
+                open_ = std::move(other.open_);
+                raw_bytes_ = other.raw_bytes_;
+                store_id_ = other.store_id_;
+                other.clear();
+            }
+            return *this;
+        }
+
+        // 追加下一个文档的正文，文档ID就是追加的顺序
+        void append(std::string_view body)
+        {
+            docs_.push_back({static_cast<uint32_t>(blocks_.size()), static_cast<uint32_t>(open_.size()), static_cast<uint32_t>(body.size())});
+            open_.append(body.data(), body.size());
+            raw_bytes_ += body.size();
+            if (open_.size() >= default_block_size)
+                compressBlock();
+        }
+
+        // 一批文档追加完成：压缩尾块并释放多余的容量
+        void seal()
+        {
+            compressBlock();
+            compressed_.shrink_to_fit();
+            docs_.shrink_to_fit();
+            blocks_.shrink_to_fit();
+            std::string().swap(open_);
+        }
+
+        // 获取文档正文，不存在时返回空串
+        // 返回值指向线程内的解压缓存，在当前线程再读取block_cache_capacity个其他块之前有效
+        std::string_view get(uint64_t id) const
+        {
+            if (id >= docs_.size())
+                return std::string_view();
+
+            const DocLoc &loc = docs_[id];
+            if (loc.block == blocks_.size())
+                return std::string_view(open_).substr(loc.offset, loc.size);
+
+            // 解压失败的块在缓存中为空串
+            const std::string &raw = loadBlock(loc.block);
+            if (raw.size() < static_cast<size_t>(loc.offset) + loc.size)
+                return std::string_view();
+            return std::string_view(raw).substr(loc.offset, loc.size);
+        }
+
+        size_t size() const
+        {
+            return docs_.size();
+        }
+
+        // 未压缩的正文总长度
+        size_t rawBytes() const
+        {
+            return raw_bytes_;
+        }
+
+        // 占用的内存
+        size_t memoryBytes() const
+        {
+            return compressed_.capacity() + open_.capacity() + docs_.capacity() * sizeof(DocLoc) + blocks_.capacity() * sizeof(Block);
+        }
+
+        void clear()
+        {
+            docs_.clear();
+            blocks_.clear();
+            compressed_.clear();
+            open_.clear();
+            raw_bytes_ = 0;
+            // 块编号重新开始，使用新的标识避免读到其他索引缓存的块
+            store_id_ = nextStoreId();
+        }
+
+    private:
+        // 压缩尾块，追加到compressed_的末尾
+        void compressBlock()
+        {
+            if (open_.empty())
+                return;
+
+            // 压缩缓冲区线程内复用
+            thread_local std::string buffer;
+            int bound = LZ4_compressBound(static_cast<int>(open_.size()));
+            if (buffer.size() < static_cast<size_t>(bound))
+                buffer.resize(bound);
+
+            uint64_t offset = compressed_.size();
+            int n = LZ4_compress_default(open_.data(), &buffer[0], static_cast<int>(open_.size()), bound);
+            if (n > 0 && static_cast<size_t>(n) < open_.size())
+                compressed_.append(buffer.data(), n);
+            else
+            {
+                // 无法压缩时按照原文保存
+                compressed_.append(open_);
+                n = 0;
+            }
+
+            blocks_.push_back({offset, static_cast<uint32_t>(n), static_cast<uint32_t>(open_.size())});
+            open_.clear();
+        }
+
+        // 解压指定的块，优先从线程内的缓存中读取
+        // 每个存储的标识唯一（复制时重新分配），同一标识下块编号对应的内容不会变化
+        const std::string &loadBlock(uint32_t block) const
+        {
+            thread_local bs_lru_cache::LruCache<uint64_t, std::string> cache(block_cache_capacity);
+
+            uint64_t key = (store_id_ << 32) | block;
+            if (const std::string *raw = cache.get(key))
+                return *raw;
+
+            const Block &b = blocks_[block];
+            const char *src = compressed_.data() + b.offset;
+            std::string &raw = cache.put(key, std::string());
+            if (b.compressed_size == 0)
+            {
+                raw.assign(src, b.raw_size);
+                return raw;
+            }
+
+            raw.resize(b.raw_size);
+            int n = LZ4_decompress_safe(src, &raw[0], static_cast<int>(b.compressed_size), static_cast<int>(b.raw_size));
+            if (n != static_cast<int>(b.raw_size))
+            {
+                LOG(Level::Warning, "解压正文失败");
+                raw.clear();
+            }
+            return raw;
+        }
+
+        static uint64_t nextStoreId()
+        {
+            static std::atomic<uint64_t> id(0);
+            return id.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+
+    private:
+        std::vector<DocLoc> docs_;  // 下标为文档ID
+        std::vector<Block> blocks_; // 已经压缩的块
+        std::string compressed_;    // 所有压缩块首尾相接
+        std::string open_;          // 尚未压缩的尾块
+        size_t raw_bytes_ = 0;      // 未压缩的正文总长度
+        uint64_t store_id_;         // 区分线程缓存中不同存储的块
+    };
+}
+
+#endif
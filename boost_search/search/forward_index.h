@@ -0,0 +1,168 @@
+#ifndef __bs_forward_index_h__
+#define __bs_forward_index_h__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <boost_search/base/public_data.h>
+#include <boost_search/search/doc_store.h>
+
+namespace bs_forward_index
+{
+    // 文档状态标记
+    const uint8_t doc_deleted = 1 << 0;      // 已经被删除或者替换（墓碑），搜索时跳过
+    const uint8_t doc_placeholder = 1 << 1;  // 无法解析的行占用的文档ID，始终处于删除状态
+    const uint8_t doc_relative_url = 1 << 2; // URL去掉了g_url_to_concat前缀
+
+    /**
+     * 按列存放的正排索引，文档ID就是追加的顺序
+     * 1. 标题和URL分别首尾相接存放在一块连续内存中，另用偏移数组记录每个文档的起止位置，
+     *    建立索引时不再为每个字段单独分配内存，读取时返回指向连续内存的string_view
+     * 2. 以g_url_to_concat开头的URL只保存之后的相对路径，读取时由前缀和相对路径两部分组成
+     * 3. 正文压缩保存在BodyStore中，见doc_store.h
+     * 4. 所有列都是定长数组或者连续内存，可以直接写入索引快照
+     */
+    class ForwardIndex
+    {
+    public:
+        ForwardIndex()
+            : title_offsets_(1, 0), url_offsets_(1, 0)
+        {
+        }
+
+        // 追加一个文档，返回文档ID
+        uint64_t append(std::string_view title, std::string_view body, std::string_view url)
+        {
+            uint8_t flags = 0;
+            std::string_view prefix = bs_public_data::g_url_to_concat;
+            if (url.size() > prefix.size() && url.compare(0, prefix.size(), prefix) == 0)
+            {
+                url.remove_prefix(prefix.size());
+                flags |= doc_relative_url;
+            }
+
+            titles_.append(title.data(), title.size());
+            title_offsets_.push_back(static_cast<uint32_t>(titles_.size()));
+            urls_.append(url.data(), url.size());
+            url_offsets_.push_back(static_cast<uint32_t>(urls_.size()));
+            bodies_.append(body);
+            flags_.push_back(flags);
+            return flags_.size() - 1;
+        }
+
+        // 追加无法解析的行对应的占位文档，所有字段为空，返回文档ID
+        uint64_t appendPlaceholder()
+        {
+            title_offsets_.push_back(static_cast<uint32_t>(titles_.size()));
+            url_offsets_.push_back(static_cast<uint32_t>(urls_.size()));
+            bodies_.append(std::string_view());
+            flags_.push_back(doc_placeholder | doc_deleted);
+            return flags_.size() - 1;
+        }
+
+        // 一批文档追加完成：压缩正文的尾块并释放多余的容量
+        void seal()
+        {
+            bodies_.seal();
+            titles_.shrink_to_fit();
+            urls_.shrink_to_fit();
+            title_offsets_.shrink_to_fit();
+            url_offsets_.shrink_to_fit();
+            flags_.shrink_to_fit();
+        }
+
+        // 文档数，包括已删除的文档
+        size_t size() const
+        {
+            return flags_.size();
+        }
+
+        // 以下读取接口要求id < size()
+
+        std::string_view getTitle(uint64_t id) const
+        {
+            return std::string_view(titles_).substr(title_offsets_[id], title_offsets_[id + 1] - title_offsets_[id]);
+        }
+
+        // 返回值在当前线程下一次读取正文之前有效，见BodyStore::get
+        std::string_view getBody(uint64_t id) const
+        {
+            return bodies_.get(id);
+        }
+
+        // URL的前缀，没有去掉前缀时为空串
+        std::string_view getUrlPrefix(uint64_t id) const
+        {
+            return (flags_[id] & doc_relative_url) ? std::string_view(bs_public_data::g_url_to_concat) : std::string_view();
+        }
+
+        // URL去掉前缀之后的部分
+        std::string_view getUrlPath(uint64_t id) const
+        {
+            return std::string_view(urls_).substr(url_offsets_[id], url_offsets_[id + 1] - url_offsets_[id]);
+        }
+
+        // 完整的URL
+        std::string getUrl(uint64_t id) const
+        {
+            std::string_view prefix = getUrlPrefix(id);
+            std::string_view path = getUrlPath(id);
+            std::string url;
+            url.reserve(prefix.size() + path.size());
+            url.append(prefix.data(), prefix.size());
+            url.append(path.data(), path.size());
+            return url;
+        }
+
+        bool isDeleted(uint64_t id) const
+        {
+            return flags_[id] & doc_deleted;
+        }
+
+        bool isPlaceholder(uint64_t id) const
+        {
+            return flags_[id] & doc_placeholder;
+        }
+
+        // 占位文档始终保持删除状态
+        void setDeleted(uint64_t id, bool deleted)
+        {
+            if (deleted || (flags_[id] & doc_placeholder))
+                flags_[id] |= doc_deleted;
+            else
+                flags_[id] &= ~doc_deleted;
+        }
+
+        const bs_doc_store::BodyStore &getBodyStore() const
+        {
+            return bodies_;
+        }
+
+        // 标题、URL和各个数组占用的内存，不包括正文
+        size_t memoryBytes() const
+        {
+            return titles_.capacity() + urls_.capacity() + (title_offsets_.capacity() + url_offsets_.capacity()) * sizeof(uint32_t) + flags_.capacity();
+        }
+
+        void clear()
+        {
+            titles_.clear();
+            urls_.clear();
+            title_offsets_.assign(1, 0);
+            url_offsets_.assign(1, 0);
+            flags_.clear();
+            bodies_.clear();
+        }
+
+    private:
+        std::string titles_;                  // 所有标题首尾相接
+        std::string urls_;                    // 所有URL（去掉前缀）首尾相接
+        std::vector<uint32_t> title_offsets_; // 第i个标题为[title_offsets_[i], title_offsets_[i + 1])
+        std::vector<uint32_t> url_offsets_;   // 第i个URL为[url_offsets_[i], url_offsets_[i + 1])
+        std::vector<uint8_t> flags_;          // 下标为文档ID，文档状态标记
+        bs_doc_store::BodyStore bodies_;      // 压缩的正文
+    };
+}
+
+#endif
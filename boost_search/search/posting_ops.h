@@ -0,0 +1,150 @@
+#ifndef __bs_posting_ops_h__
+#define __bs_posting_ops_h__
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace bs_posting_ops
+{
+    /**
+     * 有序文档ID序列的集合运算，用于布尔查询
+     * 1. 两个序列长度相差较大时，对短序列中的每个ID在长序列中倍增查找（galloping），只访问长序列的一小部分
+     * 2. 长度接近时按块比较，每次用SIMD比较4×4个ID，不相等的块整体跳过
+     * 输入序列必须严格递增
+     */
+
+    // 长序列与短序列长度之比超过该值时使用倍增查找
+    const size_t gallop_ratio = 32;
+
+    // 从begin开始倍增查找第一个不小于target的位置
+    inline size_t gallopTo(const uint32_t *data, size_t begin, size_t size, uint32_t target)
+    {
+        if (begin >= size || data[begin] >= target)
+            return begin;
+
+        // 倍增找到包含target的区间(lo, hi]
+        size_t step = 1;
+        size_t lo = begin;
+        size_t hi = begin + 1;
+        while (hi < size && data[hi] < target)
+        {
+            lo = hi;
+            step <<= 1;
+            hi = begin + step;
+        }
+        if (hi > size)
+            hi = size;
+
+        // 区间内二分
+        while (lo + 1 < hi)
+        {
+            size_t mid = lo + (hi - lo) / 2;
+            if (data[mid] < target)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        return hi;
+    }
+
+    // 倍增查找求交，small应当是较短的序列
+    inline void intersectGalloping(const uint32_t *small, size_t small_size, const uint32_t *large, size_t large_size, std::vector<uint32_t> &out)
+    {
+        size_t j = 0;
+        for (size_t i = 0; i < small_size && j < large_size; i++)
+        {
+            j = gallopTo(large, j, large_size, small[i]);
+            if (j < large_size && large[j] == small[i])
+                out.push_back(small[i]);
+        }
+    }
+
+    // 归并求交，处理块比较之后的剩余部分
+    inline void intersectScalar(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, std::vector<uint32_t> &out)
+    {
+        size_t i = 0, j = 0;
+        while (i < na && j < nb)
+        {
+            if (a[i] < b[j])
+                i++;
+            else if (a[i] > b[j])
+                j++;
+            else
+            {
+                out.push_back(a[i]);
+                i++;
+                j++;
+            }
+        }
+    }
+
+    // 按块求交：a的4个ID与b的4个ID两两比较（b循环移位3次），块尾较小的一方前进
+    inline void intersectBlock(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, std::vector<uint32_t> &out)
+    {
+        size_t i = 0, j = 0;
+#if defined(__SSE2__)
+        while (i + 4 <= na && j + 4 <= nb)
+        {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + j));
+            __m128i eq = _mm_cmpeq_epi32(va, vb);
+            eq = _mm_or_si128(eq, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1))));
+            eq = _mm_or_si128(eq, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))));
+            eq = _mm_or_si128(eq, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3))));
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+            while (mask)
+            {
+                int k = __builtin_ctz(mask);
+                out.push_back(a[i + k]);
+                mask &= mask - 1;
+            }
+
+            uint32_t amax = a[i + 3];
+            uint32_t bmax = b[j + 3];
+            if (amax <= bmax)
+                i += 4;
+            if (bmax <= amax)
+                j += 4;
+        }
+#endif
+        intersectScalar(a + i, na - i, b + j, nb - j, out);
+    }
+
+    // 求交，根据长度之比选择算法，结果写入out（会先清空）
+    inline void intersect(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, std::vector<uint32_t> &out)
+    {
+        out.clear();
+        if (na > nb)
+        {
+            std::swap(a, b);
+            std::swap(na, nb);
+        }
+        if (na == 0)
+            return;
+        if (nb / na >= gallop_ratio)
+            intersectGalloping(a, na, b, nb, out);
+        else
+            intersectBlock(a, na, b, nb, out);
+    }
+
+    // 求差：从ids中删除出现在exclude中的ID，原地修改
+    inline void subtract(std::vector<uint32_t> &ids, const uint32_t *exclude, size_t n)
+    {
+        size_t keep = 0, j = 0;
+        for (size_t i = 0; i < ids.size(); i++)
+        {
+            j = gallopTo(exclude, j, n, ids[i]);
+            if (j < n && exclude[j] == ids[i])
+                continue;
+            ids[keep++] = ids[i];
+        }
+        ids.resize(keep);
+    }
+}
+
+#endif
@@ -2,10 +2,19 @@
 #define __bs_search_engine_h__
 
 #include <algorithm>
+#include <numeric>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <boost_search/search/search_index.h>
-#include <boost_search/include/cppjieba/Jieba.hpp>
+#include <boost_search/search/posting_ops.h>
+#include <boost_search/base/epoch.h>
+#include <boost_search/base/lru_cache.h>
+#include <boost_search/base/thread_pool.h>
+#include <boost_search/search/tokenizer.h>
 #include <boost_search/base/log.h>
-#include <jsoncpp/json/json.h>
+#include <boost_search/utils/json_writer.h>
 
 namespace bs_search_engine
 {
@@ -15,135 +24,1175 @@ namespace bs_search_engine
     struct SearchIndexElement
     {
         uint64_t id;
-        std::vector<std::string> words;
+        uint64_t term_mask; // 命中的词，第i位对应ParsedQuery::score_terms[i]
         int weight;
 
         SearchIndexElement()
-            :id(0), weight(0)
+            :id(0), term_mask(0), weight(0)
         {}
+
+        SearchIndexElement(uint64_t id_, uint64_t term_mask_, int weight_)
+            :id(id_), term_mask(term_mask_), weight(weight_)
+        {}
+    };
+
+    // 词掩码最多区分63个词，之后的词共用最高的词位，第63位标记被-词排除的文档
+    const size_t max_mask_terms = 63;
+    const uint64_t excluded_bit = 1ull << 63;
+
+    inline uint64_t termBit(size_t i)
+    {
+        return 1ull << std::min(i, max_mask_terms - 1);
+    }
+
+    /**
+     * 分片内的稠密打分累加器，以文档在分片内的序号（文档ID / 分片数）为下标
+     * 每个线程一个，跨查询复用；命中的位置记录在touched中，查询结束只清理这些位置，
+     * 数组增长到分片大小之后打分过程不再分配内存
+     */
+    struct ScoreAccumulator
+    {
+        std::vector<int> weights;
+        std::vector<uint64_t> term_masks; // 不为0表示本次查询已经命中
+        std::vector<uint32_t> touched;
+
+        void prepare(size_t slots)
+        {
+            if (weights.size() < slots)
+            {
+                weights.resize(slots, 0);
+                term_masks.resize(slots, 0);
+            }
+            touched.clear();
+        }
+
+        void add(uint32_t slot, int weight, uint64_t bit)
+        {
+            if (term_masks[slot] == 0)
+                touched.push_back(slot);
+            weights[slot] += weight;
+            term_masks[slot] |= bit;
+        }
+
+        void reset()
+        {
+            for (uint32_t slot : touched)
+            {
+                weights[slot] = 0;
+                term_masks[slot] = 0;
+            }
+            touched.clear();
+        }
     };
 
+    // 短语中的一个词，offset为该词在短语中相对第一个词的位置，标点和高频词作为间隔不出现在短语中
+    struct PhraseTerm
+    {
+        uint32_t term_id;
+        uint32_t offset;
+    };
+
+    // 解析后的查询
+    struct ParsedQuery
+    {
+        std::vector<std::string> keywords;         // 参与打分的所有词，包括短语中的词
+        std::vector<std::vector<PhraseTerm>> phrases; // 每个短语中有位置信息的词，文档必须包含所有短语
+        std::vector<uint32_t> proximity_terms;      // 参与邻近度加权的词编号，不重复
+        std::vector<uint32_t> score_terms;          // keywords中在索引里存在的词编号，不重复，有其他词时不包括高频词
+        std::vector<uint32_t> required_terms;       // 必须包含的词编号（+词以及短语中的词），不重复
+        std::vector<uint32_t> excluded_terms;       // 必须排除的词编号（-词），不重复
+        std::vector<uint32_t> field_terms[bs_search_index::field_count]; // 限定字段的词编号（title:词、url:词），文档的对应字段必须包含这些词
+        std::vector<std::string> libraries;         // lib=指定的库名，文档属于其中任意一个即可
+        bool library_only = false;                  // 除了lib=和-词之外没有其他词，返回指定库中的所有文档
+        bool unmatchable = false;                   // 必须包含的词在索引中不存在，不可能有结果
+
+        bool hasFieldTerms() const
+        {
+            for (const auto &terms : field_terms)
+            {
+                if (!terms.empty())
+                    return true;
+            }
+            return false;
+        }
+    };
+
+    // 缓存的切分结果，词典版本改变后失效
+    struct CachedQuery
+    {
+        uint64_t dict_version = 0;
+        ParsedQuery query;
+    };
+
+    inline void addUniqueTerm(std::vector<uint32_t> &terms, uint32_t term_id)
+    {
+        if (std::find(terms.begin(), terms.end(), term_id) == terms.end())
+            terms.push_back(term_id);
+    }
+
+    // 结果排序规则：权重降序，权重相同时文档ID升序，保证分片合并后的顺序确定
+    inline bool compareResult(const SearchIndexElement &b1, const SearchIndexElement &b2)
+    {
+        if (b1.weight != b2.weight)
+            return b1.weight > b2.weight;
+        return b1.id < b2.id;
+    }
+
+    /**
+     * 搜索引擎，持有当前使用的索引
+     * 重新加载时在后台线程中建立新的索引，通过原子指针替换发布，
+     * 正在进行的搜索继续使用旧的索引，所有读者离开旧纪元后再释放旧的索引
+     * 索引划分为多个分片时，一次搜索在线程池中并行查询各个分片，各自取前K个结果后再合并
+     * 查询中用双引号括起来的部分作为短语，只返回包含该短语的文档；
+     * 多个词的查询根据词在文档中的最近距离额外加权，单个词的查询不会读取位置信息
+     * 以+开头的词必须包含，以-开头的词必须排除，其余的词包含任意一个即可：
+     * 存在必须包含的词时，从最短的文档ID序列开始依次求交得到候选文档，不再合并所有词的拉链
+     * 以title:或url:开头的词限定字段，文档的标题或URL必须包含这些词，只读取对应字段的拉链，
+     * 查询中只有限定字段的词时不会读取全文拉链
+     * lib=a,b限定文档所属的库（由URL得到），每个库的文档ID保存在压缩位图中；
+     * facets统计结果在各个库中的文档数，结果集转为位图后与每个库的位图求交集的大小
+     * 每个线程缓存最近查询的切分结果（词编号），翻页等重复的查询不再分词和查词典
+     */
     class SearchEngine
     {
     public:
-        SearchEngine()
-            : search_index_(bs_search_index::SearchIndex::getSearchIndexInstance())
+        static const int phrase_weight_per = 20;    // 每次短语匹配增加的权重
+        static const int proximity_weight_max = 10; // 相邻出现时的邻近度权重
+        static const uint32_t proximity_window = 8; // 超过该距离不再加权
+        static const size_t query_cache_capacity = 256; // 每个线程缓存的查询数
+
+        // shard_num为索引分片数，大于1时使用shard_num - 1个工作线程与调用线程一起查询
+        // enable_positions为false时索引不记录位置信息，短语退化为普通的词，也不做邻近度加权
+        // prune为建立索引时的停用词和文档频率上限
+        SearchEngine(const std::filesystem::path &raw_path = bs_public_data::g_rawfile_path, size_t shard_num = 1, bool enable_positions = true,
+                     const bs_search_index::PruneOptions &prune = bs_search_index::PruneOptions())
+            : raw_path_(raw_path), shard_num_(shard_num == 0 ? 1 : shard_num), positions_enabled_(enable_positions), prune_(prune), pool_(shard_num_ - 1), search_index_(new bs_search_index::SearchIndex()),
+              reload_requested_(false), stop_(false), reloading_(false), reload_count_(0), query_cache_hits_(0), query_cache_misses_(0)
         {
             // 构建索引
-            search_index_->buildIndex();
+            search_index_.load()->setShardNum(shard_num_);
+            search_index_.load()->setPositionsEnabled(positions_enabled_);
+            search_index_.load()->setPruneOptions(prune_);
+            search_index_.load()->buildIndex(raw_path_);
+            reload_thread_ = std::thread(&SearchEngine::reloadLoop, this);
         }
 
-        // 根据关键字进行搜索
-        void search(std::string &keyword, std::string &json_string)
+        // 请求在后台重新加载索引，不阻塞调用者，重新加载期间的多次请求合并为一次
+        void requestReload()
         {
-            // 对用户输入的关键字进行切分
+            std::unique_lock<std::mutex> lock(reload_mtx_);
+            reload_requested_ = true;
+            reload_cond_.notify_one();
+        }
 
-            std::vector<std::string> keywords;
-            jieba_.CutForSearch(keyword, keywords);
+        // 重新加载索引并替换当前索引，返回时旧的索引已经释放
+        // 文本文件只有追加时复制当前索引再增量更新，否则重新建立索引
+        bool reload()
+        {
+            std::unique_lock<std::mutex> lock(swap_mtx_);
+            bs_search_index::SearchIndex *old_index = search_index_.load(std::memory_order_acquire);
+            bs_search_index::SearchIndex *new_index = new bs_search_index::SearchIndex();
 
-            std::vector<SearchIndexElement> results;
-            std::unordered_map<uint64_t, SearchIndexElement> select_map;
-            for (auto &word : keywords)
-            {
-                // 忽略大小写
-                boost::to_lower(word);
-                // 查倒排索引
-                std::vector<bs_search_index::BackwardIndexElement> *ret_ptr = search_index_->getBackwardIndexElement(word);
-                if (!ret_ptr)
+            bool updated = false;
+            if (old_index->canApplyDelta(raw_path_))
+            {
+                new_index->copyIndexFrom(*old_index);
+                updated = new_index->applyDelta(raw_path_);
+            }
+            if (!updated)
+            {
+                delete new_index;
+                new_index = new bs_search_index::SearchIndex();
+                new_index->setShardNum(shard_num_);
+                new_index->setPositionsEnabled(positions_enabled_);
+                new_index->setPruneOptions(prune_);
+                if (!new_index->buildIndex(raw_path_))
+                {
+                    delete new_index;
+                    LOG(Level::Warning, "重新加载索引失败，继续使用当前索引");
+                    return false;
+                }
+            }
+
+            // 发布新的索引，等待仍在使用旧索引的搜索结束后释放
+            search_index_.store(new_index, std::memory_order_release);
+            bs_epoch::EpochManager::instance().synchronize();
+            delete old_index;
+
+            reload_count_.fetch_add(1, std::memory_order_relaxed);
+            LOG(Level::Info, "索引重新加载完成，文档数：{}，已删除：{}", new_index->getDocCount(), new_index->getDeletedCount());
+            return true;
+        }
+
+        // 是否正在重新加载
+        bool isReloading() const
+        {
+            return reloading_.load(std::memory_order_relaxed);
+        }
+
+        // 已经完成的重新加载次数
+        uint64_t getReloadCount() const
+        {
+            return reload_count_.load(std::memory_order_relaxed);
+        }
+
+        // 查询切分缓存命中的次数
+        uint64_t getQueryCacheHits() const
+        {
+            return query_cache_hits_.load(std::memory_order_relaxed);
+        }
+
+        // 查询切分缓存未命中的次数
+        uint64_t getQueryCacheMisses() const
+        {
+            return query_cache_misses_.load(std::memory_order_relaxed);
+        }
+
+        // 根据关键字进行搜索，返回满足查询的文档总数
+        // 跳过排在前面的offset个结果后最多返回top_k个，top_k为0时返回之后的全部结果，只有返回的结果截取摘要
+        size_t search(std::string &keyword, std::string &json_string, size_t top_k = 0, size_t offset = 0)
+        {
+            // 搜索期间持有当前索引，重新加载不会释放正在使用的索引
+            bs_epoch::EpochGuard guard;
+            bs_search_index::SearchIndex *index = search_index_.load(std::memory_order_acquire);
+
+            // 对用户输入的关键字进行切分，同一线程中重复的查询直接使用缓存的结果
+            const ParsedQuery &query = resolveQuery(keyword, index);
+
+            // 各个分片并行查询
+            size_t shard_num = index->getShardNum();
+            // 每个分片需要保留前offset + top_k个结果才能保证合并后这一页的结果正确
+            size_t keep = top_k == 0 ? 0 : offset + top_k;
+            std::vector<std::vector<SearchIndexElement>> partial(shard_num);
+            std::vector<size_t> totals(shard_num, 0);
+            std::vector<const bs_bitmap::RoaringBitmap *> libs;
+            if (!query.unmatchable && resolveLibraries(index, query, libs))
+                pool_.parallelFor(shard_num, [&](size_t shard)
+                                  { totals[shard] = searchShard(index, shard, query, libs, keep, partial[shard]); });
+
+            std::vector<SearchIndexElement> results = mergeResults(partial, keep);
+            results.erase(results.begin(), results.begin() + std::min(offset, results.size()));
+            size_t total = 0;
+            for (size_t n : totals)
+                total += n;
+
+            // 需要高亮的词：查询中在索引里存在的词，不包括空白和标点
+            const auto &dict = index->getTermDictionary();
+            std::vector<uint32_t> snippet_terms;
+            std::vector<uint64_t> snippet_bits;
+            std::vector<std::string_view> highlight_terms;
+            for (size_t i = 0; i < query.score_terms.size(); i++)
+            {
+                uint32_t term_id = query.score_terms[i];
+                if (!bs_search_index::isWordToken(dict.getTerm(term_id)))
                     continue;
-                // 插入结果
-                for (auto &bi : *ret_ptr)
+                snippet_terms.push_back(term_id);
+                snippet_bits.push_back(termBit(i));
+                highlight_terms.push_back(dict.getTerm(term_id));
+            }
+
+            // 只有最终返回的文档才生成摘要。正文按照文档ID顺序存放在压缩块中，而结果按照权重排列，
+            // 按照排名读取正文会在块之间来回跳转、线程内的块缓存几乎总是失效，
+            // 因此先按照文档ID顺序截取所有摘要（每个块只解压一次），首尾相接存放在线程内复用的缓冲区中
+            thread_local std::string snippets;
+            thread_local std::vector<uint32_t> order;
+            thread_local std::vector<std::pair<size_t, size_t>> spans; // 下标为排名，摘要在snippets中的起止位置
+            const auto &forward = index->getForwardIndex();
+            order.resize(results.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+                      { return results[a].id < results[b].id; });
+            snippets.clear();
+            snippets.reserve(results.size() * (prev_words + after_words + 64));
+            spans.resize(results.size());
+            for (uint32_t r : order)
+            {
+                const SearchIndexElement &el = results[r];
+                // 以匹配的词在正文中最早出现的位置为中心截取摘要，只出现在标题中时从正文开头截取
+                // 只查找词掩码中命中的词
+                uint32_t anchor = bs_search_index::no_body_offset;
+                for (size_t i = 0; i < snippet_terms.size(); i++)
                 {
-                    // 如果文档ID已经存在，说明已经存在，否则不存在
-                    if (select_map.find(bi.id) == select_map.end())
-                    {
-                        // 获取当前文档搜索结构节点，不存在自动插入，存在直接获取
-                        auto &el = select_map[bi.id];
-                        // 如果是新节点，直接赋值；如果是重复出现的节点，覆盖
-                        el.id = bi.id;
-                        // 如果是新节点，第一次添加；如果是重复节点，追加
-                        el.words.push_back(bi.word);
-                        // 如果是新节点，直接赋值；如果是重复节点，累加
-                        el.weight += bi.weight;
-                    }
+                    if (el.term_mask & snippet_bits[i])
+                        anchor = std::min(anchor, index->getBodyOffset(snippet_terms[i], el.id));
                 }
+
+                // 正文读取之后立即截取摘要，返回的正文只在下一次读取之前有效
+                size_t start = snippets.size();
+                appendSnippet(snippets, forward.getBody(el.id), anchor, highlight_terms);
+                spans[r] = {start, snippets.size()};
             }
 
-            // 遍历select_map存储结果
-            for (auto &pair : select_map)
-                results.push_back(std::move(pair.second));
+            // 按照排名直接生成JSON字符串，摘要转义后追加到结果中
+            json_string.clear();
+            json_string.reserve(results.size() * (prev_words + after_words + 256));
+            bs_json_writer::JsonWriter writer(json_string);
+            writer.beginArray();
+            for (size_t r = 0; r < results.size(); r++)
+            {
+                const SearchIndexElement &el = results[r];
+                // 键按照字典序输出，与之前使用Json::FastWriter生成的结果一致
+                writer.beginObject();
+                writer.key("body");
+                writer.value(std::string_view(snippets).substr(spans[r].first, spans[r].second - spans[r].first));
+                writer.key("title");
+                writer.value(forward.getTitle(el.id));
+                writer.key("url");
+                writer.value(forward.getUrlPrefix(el.id), forward.getUrlPath(el.id));
+                writer.endObject();
+            }
+            writer.endArray();
+            return total;
+        }
+
+        // 前缀补全，返回以prefix开头的最多n个词，按照包含该词的文档数降序排列
+        // 不经过分词和倒排索引，可以在用户每次输入时调用
+        void suggest(std::string prefix, std::string &json_string, size_t n = bs_suggest_index::suggest_top_n)
+        {
+            boost::to_lower(prefix);
+
+            bs_epoch::EpochGuard guard;
+            bs_search_index::SearchIndex *index = search_index_.load(std::memory_order_acquire);
+            const auto &dict = index->getTermDictionary();
+            const auto &suggest_index = index->getSuggestIndex();
 
-            std::stable_sort(results.begin(), results.end(), [](const SearchIndexElement &b1, const SearchIndexElement &b2)
-                             { return b1.weight > b2.weight; });
+            std::vector<uint32_t> term_ids;
+            suggest_index.suggest(dict, prefix, n, term_ids);
 
-            // 转换为JSON字符串
-            Json::Value root;
-            for (auto &el : results)
+            json_string.clear();
+            bs_json_writer::JsonWriter writer(json_string);
+            writer.beginArray();
+            for (uint32_t id : term_ids)
             {
-                // 通过正排索引获取文章内容
-                bs_search_index::SelectedDocInfo *sd = search_index_->getForwardIndexDocInfo(el.id);
+                writer.beginObject();
+                writer.key("df");
+                writer.value(static_cast<uint64_t>(suggest_index.getDocFreq(id)));
+                writer.key("word");
+                writer.value(dict.getTerm(id));
+                writer.endObject();
+            }
+            writer.endArray();
+        }
+
+        // 统计搜索结果在各个库中的文档数，按照文档数降序排列，文档数相同时按照库名排列，不输出文档数为0的库
+        // 各个分片的结果合并为一个位图，再与每个库的位图求交集的大小，不生成交集
+        void facets(std::string &keyword, std::string &json_string)
+        {
+            bs_epoch::EpochGuard guard;
+            bs_search_index::SearchIndex *index = search_index_.load(std::memory_order_acquire);
+            const ParsedQuery &query = resolveQuery(keyword, index);
 
-                Json::Value item;
-                item["title"] = sd->rd.title;
-                item["body"] = getPartialBodyWithKeyword(sd->rd.body, el.words[0]);
-                item["url"] = sd->rd.url;
+            size_t shard_num = index->getShardNum();
+            std::vector<std::vector<uint32_t>> partial(shard_num);
+            std::vector<const bs_bitmap::RoaringBitmap *> libs;
+            if (!query.unmatchable && resolveLibraries(index, query, libs))
+                pool_.parallelFor(shard_num, [&](size_t shard)
+                                  {
+                                      thread_local std::vector<SearchIndexElement> hits;
+                                      collectShard(index, shard, query, libs, hits);
+                                      partial[shard].reserve(hits.size());
+                                      for (auto &el : hits)
+                                          partial[shard].push_back(static_cast<uint32_t>(el.id));
+                                  });
 
-                // 将item作为一个JSON对象插入到root中作为子JSON对象
-                root.append(item);
+            // 按照递增顺序加入位图，每次只在容器末尾追加
+            std::vector<uint32_t> ids;
+            for (size_t shard = 0; shard < shard_num; shard++)
+            {
+                if (ids.empty())
+                    ids.swap(partial[shard]);
+                else
+                    ids.insert(ids.end(), partial[shard].begin(), partial[shard].end());
             }
+            std::sort(ids.begin(), ids.end());
+            bs_bitmap::RoaringBitmap result;
+            for (uint32_t id : ids)
+                result.add(id);
 
-            Json::FastWriter writer;
-            json_string = writer.write(root);
+            std::vector<std::pair<uint64_t, uint32_t>> counts;
+            if (!result.empty())
+            {
+                for (uint32_t lib = 0; lib < index->getLibraryCount(); lib++)
+                {
+                    uint64_t n = index->getLibraryDocs(lib).andCardinality(result);
+                    if (n > 0)
+                        counts.emplace_back(n, lib);
+                }
+            }
+            std::sort(counts.begin(), counts.end(), [&](const std::pair<uint64_t, uint32_t> &a, const std::pair<uint64_t, uint32_t> &b)
+                      {
+                          if (a.first != b.first)
+                              return a.first > b.first;
+                          return index->getLibraryName(a.second) < index->getLibraryName(b.second);
+                      });
+
+            json_string.clear();
+            bs_json_writer::JsonWriter writer(json_string);
+            writer.beginArray();
+            for (auto &c : counts)
+            {
+                writer.beginObject();
+                writer.key("count");
+                writer.value(c.first);
+                writer.key("lib");
+                writer.value(index->getLibraryName(c.second));
+                writer.endObject();
+            }
+            writer.endArray();
         }
 
         ~SearchEngine()
         {
+            {
+                std::unique_lock<std::mutex> lock(reload_mtx_);
+                stop_ = true;
+                reload_cond_.notify_one();
+            }
+            reload_thread_.join();
+            delete search_index_.load();
         }
 
-    private:
         static const int prev_words = 50;
         static const int after_words = 100;
-        std::string getPartialBodyWithKeyword(std::string_view body, std::string_view keyword)
+        static constexpr const char *highlight_begin = "<span class=\"highlight\">";
+        static constexpr const char *highlight_end = "</span>";
+
+        // 截取anchor（字节偏移）附近的内容作为摘要，边界对齐到UTF-8字符
+        // 摘要中的HTML特殊字符会被转义，terms中的所有词（忽略ASCII大小写）用highlight_begin/highlight_end包围
+        static std::string getSnippet(std::string_view body, size_t anchor, const std::vector<std::string_view> &terms)
+        {
+            std::string out;
+            appendSnippet(out, body, anchor, terms);
+            return out;
+        }
+
+        // 与getSnippet相同，结果追加到out中
+        static void appendSnippet(std::string &out, std::string_view body, size_t anchor, const std::vector<std::string_view> &terms)
+        {
+            if (anchor >= body.size())
+                anchor = 0;
+            size_t start = anchor > static_cast<size_t>(prev_words) ? anchor - prev_words : 0;
+            size_t end = std::min(body.size(), anchor + after_words);
+            while (start > 0 && isUtf8Continuation(body[start]))
+                start--;
+            while (end < body.size() && isUtf8Continuation(body[end]))
+                end++;
+            std::string_view window = body.substr(start, end - start);
+
+            // 不需要处理的连续字节整段复制，只在词首尝试匹配
+            out.reserve(out.size() + window.size() + 64);
+            size_t plain = 0, i = 0;
+            while (i < window.size())
+            {
+                char c = window[i];
+                size_t len = 0;
+                if (!isUtf8Continuation(c) && (i == 0 || !isWordByte(c) || !isWordByte(window[i - 1])))
+                    len = matchTerm(window, i, terms);
+
+                if (len > 0)
+                {
+                    out.append(window.data() + plain, i - plain);
+                    out += highlight_begin;
+                    appendEscaped(out, window.substr(i, len));
+                    out += highlight_end;
+                    i += len;
+                    plain = i;
+                }
+                else if (c == '&' || c == '<' || c == '>' || c == '"' || c == '\'')
+                {
+                    out.append(window.data() + plain, i - plain);
+                    appendEscaped(out, window.substr(i, 1));
+                    plain = ++i;
+                }
+                else
+                    i++;
+            }
+            out.append(window.data() + plain, window.size() - plain);
+        }
+
+    private:
+        static bool isUtf8Continuation(char c)
+        {
+            return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+        }
+
+        // ASCII字母、数字和下划线（例如shared_ptr），只处理ASCII，避免每个字节调用与区域设置相关的函数
+        static bool isWordByte(char c)
+        {
+            unsigned char u = static_cast<unsigned char>(c);
+            return static_cast<unsigned char>(u - '0') < 10 || static_cast<unsigned char>((u | 0x20) - 'a') < 26 || u == '_';
+        }
+
+        static char asciiLower(char c)
+        {
+            return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+        }
+
+        // 返回window中从pos开始匹配的最长的词的长度，没有匹配时返回0
+        // 以字母或数字开头（结尾）的词要求前（后）一个字符不是字母、数字或下划线，避免高亮单词的一部分
+        static size_t matchTerm(std::string_view window, size_t pos, const std::vector<std::string_view> &terms)
+        {
+            size_t best = 0;
+            char first = asciiLower(window[pos]);
+            for (std::string_view term : terms)
+            {
+                if (term[0] != first || term.size() <= best || term.size() > window.size() - pos)
+                    continue;
+                bool equal = true;
+                for (size_t k = 0; k < term.size() && equal; k++)
+                    equal = asciiLower(window[pos + k]) == term[k];
+                if (!equal)
+                    continue;
+                if (isWordByte(term.front()) && pos > 0 && isWordByte(window[pos - 1]))
+                    continue;
+                size_t next = pos + term.size();
+                if (isWordByte(term.back()) && next < window.size() && isWordByte(window[next]))
+                    continue;
+                best = term.size();
+            }
+            return best;
+        }
+
+        static void appendEscaped(std::string &out, std::string_view text)
+        {
+            for (char c : text)
+            {
+                switch (c)
+                {
+                case '&': out += "&amp;"; break;
+                case '<': out += "&lt;"; break;
+                case '>': out += "&gt;"; break;
+                case '"': out += "&quot;"; break;
+                case '\'': out += "&#39;"; break;
+                default: out.push_back(c); break;
+                }
+            }
+        }
+
+        // 获取查询的切分结果，查询先把ASCII字母转为小写（分词结果本来就是小写）再作为缓存的键和切分的输入，
+        // 只是大小写不同的查询共用同一个结果；返回的引用在当前线程下一次调用之前有效
+        const ParsedQuery &resolveQuery(const std::string &keyword, bs_search_index::SearchIndex *index)
+        {
+            thread_local bs_lru_cache::LruCache<std::string, CachedQuery> cache(query_cache_capacity);
+            thread_local std::string key;
+            key.assign(keyword);
+            bs_tokenizer::asciiToLower(&key[0], key.size());
+
+            uint64_t version = index->getDictionaryVersion();
+            CachedQuery *cached = cache.get(key);
+            if (cached && cached->dict_version == version)
+            {
+                query_cache_hits_.fetch_add(1, std::memory_order_relaxed);
+                return cached->query;
+            }
+
+            query_cache_misses_.fetch_add(1, std::memory_order_relaxed);
+            CachedQuery entry;
+            entry.dict_version = version;
+            parseQuery(key, index, entry.query);
+            return cache.put(key, std::move(entry)).query;
+        }
+
+        // 切分用户输入，双引号中的内容作为短语，缺少右引号时引号按普通字符处理
+        void parseQuery(const std::string &keyword, bs_search_index::SearchIndex *index, ParsedQuery &query)
+        {
+            const auto &dict = index->getTermDictionary();
+            std::string plain;
+            size_t start = 0;
+            while (start < keyword.size())
+            {
+                size_t open = keyword.find('"', start);
+                size_t close = open == std::string::npos ? std::string::npos : keyword.find('"', open + 1);
+                if (close == std::string::npos)
+                {
+                    plain.append(keyword, start, std::string::npos);
+                    break;
+                }
+                plain.append(keyword, start, open - start);
+                plain.push_back(' ');
+
+                std::vector<std::string> words;
+                tokenizer_.cutForSearch(keyword.substr(open + 1, close - open - 1), words);
+                // 位置编号与建立索引时相同：空白不占用位置，标点和高频词占用位置但没有位置信息，作为间隔
+                std::vector<PhraseTerm> phrase;
+                std::vector<uint32_t> phrase_words;
+                bool missing = false;
+                uint32_t offset = 0;
+                for (auto &word : words)
+                {
+                    if (!bs_search_index::isBlankToken(word))
+                    {
+                        if (bs_search_index::isWordToken(word))
+                        {
+                            uint32_t term_id = dict.find(word);
+                            missing |= term_id == bs_term_dictionary::npos;
+                            phrase_words.push_back(term_id);
+                            if (term_id != bs_term_dictionary::npos && !index->isCommonTerm(term_id))
+                                phrase.push_back({term_id, offset});
+                        }
+                        offset++;
+                    }
+                    query.keywords.push_back(std::move(word));
+                }
+                // 只有一个词的短语等同于普通的词；文档必须包含短语中所有的词，
+                // 有位置信息的词少于两个时（例如全部是高频词）不检查相邻关系
+                if (phrase_words.size() > 1 && index->hasPositions())
+                {
+                    query.unmatchable |= missing;
+                    if (!missing)
+                    {
+                        for (uint32_t term_id : phrase_words)
+                            addUniqueTerm(query.required_terms, term_id);
+                    }
+                    if (!missing && phrase.size() > 1)
+                    {
+                        uint32_t first = phrase[0].offset;
+                        for (auto &term : phrase)
+                            term.offset -= first;
+                        query.phrases.push_back(std::move(phrase));
+                    }
+                }
+                start = close + 1;
+            }
+
+            // 取出以+或-开头的词，其余部分一起切分
+            std::string rest;
+            size_t pos = 0;
+            while (pos < plain.size())
+            {
+                size_t end = plain.find_first_of(" \t\r\n", pos);
+                if (end == std::string::npos)
+                    end = plain.size();
+                if (end == pos)
+                {
+                    rest.push_back(plain[pos++]);
+                    continue;
+                }
+
+                char op = plain[pos];
+                std::string_view token(plain.data() + pos, end - pos);
+                size_t field = fieldPrefix(token);
+                if (token.size() > 4 && token.compare(0, 4, "lib=") == 0)
+                    parseLibraries(token.substr(4), query);
+                else if (field != bs_search_index::field_count)
+                    parseFieldTerm(std::string(token.substr(token.find(':') + 1)), static_cast<bs_search_index::DocField>(field), dict, query);
+                else if ((op == '+' || op == '-') && end - pos > 1)
+                    parseBooleanTerm(plain.substr(pos + 1, end - pos - 1), op == '+', dict, query);
+                else
+                    rest.append(plain, pos, end - pos);
+                pos = end;
+            }
+
+            std::vector<std::string> words;
+            tokenizer_.cutForSearch(rest, words);
+            // 分词结果已经转为小写，忽略大小写
+            for (auto &word : words)
+                query.keywords.push_back(std::move(word));
+
+            // 高频词只在查询中没有其他词时参与打分，也不参与邻近度计算
+            std::vector<uint32_t> common_terms;
+            for (auto &word : query.keywords)
+            {
+                uint32_t term_id = dict.find(word);
+                if (term_id == bs_term_dictionary::npos)
+                    continue;
+                if (index->isCommonTerm(term_id))
+                {
+                    addUniqueTerm(common_terms, term_id);
+                    continue;
+                }
+                addUniqueTerm(query.score_terms, term_id);
+                if (index->hasPositions())
+                    addUniqueTerm(query.proximity_terms, term_id);
+            }
+            if (query.score_terms.empty())
+                query.score_terms = std::move(common_terms);
+            if (query.proximity_terms.size() < 2)
+                query.proximity_terms.clear();
+
+            query.library_only = !query.libraries.empty() && query.required_terms.empty() && !query.hasFieldTerms() &&
+                                 std::none_of(query.keywords.begin(), query.keywords.end(), [](const std::string &word)
+                                              { return bs_search_index::isWordToken(word); });
+        }
+
+        // 解析lib=之后以逗号分隔的库名，查询已经转为小写
+        static void parseLibraries(std::string_view text, ParsedQuery &query)
+        {
+            size_t pos = 0;
+            while (pos <= text.size())
+            {
+                size_t end = text.find(',', pos);
+                if (end == std::string_view::npos)
+                    end = text.size();
+                std::string name(text.substr(pos, end - pos));
+                if (!name.empty() && std::find(query.libraries.begin(), query.libraries.end(), name) == query.libraries.end())
+                    query.libraries.push_back(std::move(name));
+                pos = end + 1;
+            }
+        }
+
+        // 查找lib=指定的库的文档位图，指定了库但都不存在时返回false，不可能有结果
+        // 库随索引一起重新建立，每次搜索根据当前索引查找，不放在切分缓存中
+        static bool resolveLibraries(bs_search_index::SearchIndex *index, const ParsedQuery &query, std::vector<const bs_bitmap::RoaringBitmap *> &libs)
+        {
+            for (const auto &name : query.libraries)
+            {
+                if (const bs_bitmap::RoaringBitmap *docs = index->findLibrary(name))
+                    libs.push_back(docs);
+            }
+            return query.libraries.empty() || !libs.empty();
+        }
+
+        // 切分+词或-词，+词同时参与打分，索引中不存在的-词忽略
+        void parseBooleanTerm(const std::string &text, bool required, const bs_term_dictionary::TermDictionary &dict, ParsedQuery &query)
+        {
+            std::vector<std::string> words;
+            tokenizer_.cutForSearch(text, words);
+            for (auto &word : words)
+            {
+                // 空白和标点没有建立索引
+                if (!bs_search_index::isWordToken(word))
+                    continue;
+                uint32_t term_id = dict.find(word);
+                if (required)
+                {
+                    if (term_id == bs_term_dictionary::npos)
+                        query.unmatchable = true;
+                    else
+                        addUniqueTerm(query.required_terms, term_id);
+                    query.keywords.push_back(std::move(word));
+                }
+                else if (term_id != bs_term_dictionary::npos)
+                    addUniqueTerm(query.excluded_terms, term_id);
+            }
+        }
+
+        // 以title:或url:开头且冒号之后还有内容时返回对应的字段，否则返回field_count，查询已经转为小写
+        static size_t fieldPrefix(std::string_view token)
+        {
+            static const std::string_view prefixes[bs_search_index::field_count] = {"title:", "url:"};
+            for (size_t f = 0; f < bs_search_index::field_count; f++)
+            {
+                if (token.size() > prefixes[f].size() && token.compare(0, prefixes[f].size(), prefixes[f]) == 0)
+                    return f;
+            }
+            return bs_search_index::field_count;
+        }
+
+        // 切分限定字段的词，文档的对应字段必须包含其中所有的词，这些词不读取全文拉链
+        void parseFieldTerm(const std::string &text, bs_search_index::DocField field, const bs_term_dictionary::TermDictionary &dict, ParsedQuery &query)
+        {
+            std::vector<std::string> words;
+            tokenizer_.cutForSearch(text, words);
+            for (auto &word : words)
+            {
+                if (!bs_search_index::isWordToken(word))
+                    continue;
+                uint32_t term_id = dict.find(word);
+                if (term_id == bs_term_dictionary::npos)
+                    query.unmatchable = true;
+                else
+                    addUniqueTerm(query.field_terms[field], term_id);
+            }
+        }
+
+        // 统计短语在文档中出现的次数：每个词出现在第一个词之后对应的相对位置
+        static int countPhrase(bs_search_index::SearchIndex *index, size_t shard, uint64_t doc_id, const std::vector<PhraseTerm> &phrase,
+                               std::vector<uint32_t> &starts, std::vector<uint32_t> &positions)
+        {
+            if (!index->getPositions(phrase[0].term_id, shard, doc_id, starts))
+                return 0;
+            for (size_t i = 1; i < phrase.size() && !starts.empty(); i++)
+            {
+                if (!index->getPositions(phrase[i].term_id, shard, doc_id, positions))
+                    return 0;
+                // 两个有序序列求交，保留第i个词出现在相对位置上的起始位置
+                uint32_t offset = phrase[i].offset;
+                size_t keep = 0, k = 0;
+                for (uint32_t s : starts)
+                {
+                    while (k < positions.size() && positions[k] < s + offset)
+                        k++;
+                    if (k < positions.size() && positions[k] == s + offset)
+                        starts[keep++] = s;
+                }
+                starts.resize(keep);
+            }
+            return static_cast<int>(starts.size());
+        }
+
+        // 计算查询中不同的词在文档中的最近距离，少于两个词出现时返回0
+        static uint32_t minTermDistance(bs_search_index::SearchIndex *index, size_t shard, uint64_t doc_id, const std::vector<uint32_t> &terms,
+                                        std::vector<std::vector<uint32_t>> &lists)
+        {
+            size_t found = 0;
+            for (uint32_t term_id : terms)
+            {
+                if (index->getPositions(term_id, shard, doc_id, lists[found]))
+                    found++;
+            }
+            if (found < 2)
+                return 0;
+
+            uint32_t best = UINT32_MAX;
+            for (size_t a = 0; a < found; a++)
+            {
+                for (size_t b = a + 1; b < found; b++)
+                {
+                    const auto &x = lists[a];
+                    const auto &y = lists[b];
+                    size_t i = 0, j = 0;
+                    while (i < x.size() && j < y.size())
+                    {
+                        uint32_t d = x[i] < y[j] ? y[j] - x[i] : x[i] - y[j];
+                        best = std::min(best, d);
+                        if (x[i] < y[j])
+                            i++;
+                        else
+                            j++;
+                    }
+                }
+            }
+            return best;
+        }
+
+        // 根据短语和邻近度调整权重，不包含所有短语的文档被剔除，返回false
+        static bool applyPositionalScore(bs_search_index::SearchIndex *index, size_t shard, const ParsedQuery &query, SearchIndexElement &el,
+                                         std::vector<std::vector<uint32_t>> &lists)
+        {
+            for (const auto &phrase : query.phrases)
+            {
+                int cnt = countPhrase(index, shard, el.id, phrase, lists[0], lists[1]);
+                if (cnt == 0)
+                    return false;
+                el.weight += cnt * phrase_weight_per;
+            }
+
+            if (!query.proximity_terms.empty())
+            {
+                uint32_t d = minTermDistance(index, shard, el.id, query.proximity_terms, lists);
+                if (d > 0 && d <= proximity_window)
+                    el.weight += static_cast<int>(proximity_weight_max * (proximity_window + 1 - d) / proximity_window);
+            }
+            return true;
+        }
+
+        // 在单个分片中查询，结果按照权重排序并只保留前top_k个，返回截断之前的结果数
+        // 候选结果使用线程内复用的缓冲区，只有最终保留的结果写入results
+        size_t searchShard(bs_search_index::SearchIndex *index, size_t shard, const ParsedQuery &query, const std::vector<const bs_bitmap::RoaringBitmap *> &libs,
+                         size_t top_k, std::vector<SearchIndexElement> &results)
+        {
+            thread_local std::vector<SearchIndexElement> hits;
+            collectShard(index, shard, query, libs, hits);
+
+            size_t cnt = hits.size();
+            if (top_k > 0 && top_k < hits.size())
+            {
+                std::partial_sort(hits.begin(), hits.begin() + top_k, hits.end(), compareResult);
+                cnt = top_k;
+            }
+            else
+                std::sort(hits.begin(), hits.end(), compareResult);
+            results.assign(hits.begin(), hits.begin() + cnt);
+            return hits.size();
+        }
+
+        // 收集单个分片中满足查询的文档及其权重，不排序；libs不为空时只保留属于其中任意一个库的文档，
+        // 库的位图在打分之前与候选文档或者拉链求交，不在命中之后逐个判断
+        void collectShard(bs_search_index::SearchIndex *index, size_t shard, const ParsedQuery &query, const std::vector<const bs_bitmap::RoaringBitmap *> &libs,
+                          std::vector<SearchIndexElement> &hits)
+        {
+            hits.clear();
+            if (query.library_only)
+            {
+                collectLibraries(index, shard, query, libs, hits);
+                return;
+            }
+            if (query.required_terms.empty() && !query.hasFieldTerms())
+                collectAny(index, shard, query, libs, hits);
+            else
+                collectAll(index, shard, query, libs, hits);
+
+            // 需要时根据位置信息调整权重，不包含短语的文档被剔除
+            if (!query.phrases.empty() || !query.proximity_terms.empty())
+            {
+                thread_local std::vector<std::vector<uint32_t>> lists;
+                if (lists.size() < std::max<size_t>(2, query.proximity_terms.size()))
+                    lists.resize(std::max<size_t>(2, query.proximity_terms.size()));
+                size_t keep = 0;
+                for (size_t i = 0; i < hits.size(); i++)
+                {
+                    if (!applyPositionalScore(index, shard, query, hits[i], lists))
+                        continue;
+                    hits[keep++] = hits[i];
+                }
+                hits.resize(keep);
+            }
+        }
+
+        // 查询中只有lib=和-词：返回指定库在本分片中的所有文档，权重都为0，按照文档ID排列
+        static void collectLibraries(bs_search_index::SearchIndex *index, size_t shard, const ParsedQuery &query, const std::vector<const bs_bitmap::RoaringBitmap *> &libs,
+                                     std::vector<SearchIndexElement> &hits)
         {
-            // 找到关键字
-            // size_t pos = body.find(keyword);
-            auto pos_t = std::search(body.begin(), body.end(), keyword.begin(), keyword.end(), [](char c1, char c2)
-            { 
-                return std::tolower(c1) == std::tolower(c2); 
-            });
+            size_t shard_num = index->getShardNum();
+            thread_local std::vector<uint32_t> candidates;
+            candidates.clear();
+            for (const bs_bitmap::RoaringBitmap *docs : libs)
+            {
+                docs->forEach([&](uint32_t id)
+                              {
+                                  if (id % shard_num == shard)
+                                      candidates.push_back(id);
+                              });
+            }
+            // 一个文档只属于一个库，多个库的文档合并后重新排序即可
+            if (libs.size() > 1)
+                std::sort(candidates.begin(), candidates.end());
 
-            if (pos_t == body.end())
+            for (uint32_t term_id : query.excluded_terms)
             {
-                LOG(Level::Warning, "无法找到关键字，无法截取文章内容");
-                return "Fail to cut body, can't find keyword";
+                const std::vector<uint32_t> *ids = index->getDocIds(term_id, shard);
+                if (ids)
+                    bs_posting_ops::subtract(candidates, ids->data(), ids->size());
             }
 
-            int pos = std::distance(body.begin(), pos_t);
+            for (uint32_t id : candidates)
+            {
+                if (!index->isDocDeleted(id))
+                    hits.emplace_back(id, 0, 0);
+            }
+        }
 
-            // 默认起始位置为0，终止位置为body字符串最后一个字符
-            int start = 0;
-            int end = static_cast<int>(body.size() - 1);
+        // 存在必须包含的词或者限定字段的词：从最短的文档ID序列开始依次求交，再排除-词，最后逐个词累加候选文档的权重
+        void collectAll(bs_search_index::SearchIndex *index, size_t shard, const ParsedQuery &query, const std::vector<const bs_bitmap::RoaringBitmap *> &libs,
+                        std::vector<SearchIndexElement> &hits)
+        {
+            thread_local std::vector<const std::vector<uint32_t> *> lists;
+            lists.clear();
+            for (uint32_t term_id : query.required_terms)
+            {
+                const std::vector<uint32_t> *ids = index->getDocIds(term_id, shard);
+                if (!ids)
+                    return;
+                lists.push_back(ids);
+            }
+            // 限定字段的词使用对应字段的拉链
+            for (size_t f = 0; f < bs_search_index::field_count; f++)
+            {
+                for (uint32_t term_id : query.field_terms[f])
+                {
+                    const std::vector<uint32_t> *ids = index->getFieldDocIds(static_cast<bs_search_index::DocField>(f), term_id, shard);
+                    if (!ids)
+                        return;
+                    lists.push_back(ids);
+                }
+            }
+            std::sort(lists.begin(), lists.end(), [](const std::vector<uint32_t> *a, const std::vector<uint32_t> *b)
+                      { return a->size() < b->size(); });
 
-            // 如果pos位置前有50个字符，就取前50个字符
-            if (static_cast<int>(pos) - prev_words > start)
-                start = pos - prev_words;
-            // 如果pos位置后有100个字符，就取后100个字符
-            if (pos + static_cast<int>(keyword.size()) + after_words < end)
-                end = pos + static_cast<int>(keyword.size()) + after_words;
+            thread_local std::vector<uint32_t> candidates;
+            thread_local std::vector<uint32_t> tmp;
+            candidates.assign(lists[0]->begin(), lists[0]->end());
+            for (size_t i = 1; i < lists.size() && !candidates.empty(); i++)
+            {
+                bs_posting_ops::intersect(candidates.data(), candidates.size(), lists[i]->data(), lists[i]->size(), tmp);
+                candidates.swap(tmp);
+            }
+            // 只保留指定库中的文档，一个文档只属于一个库，多个库的结果合并后重新排序即可
+            if (!libs.empty())
+            {
+                tmp.clear();
+                for (const bs_bitmap::RoaringBitmap *docs : libs)
+                    docs->forEachContained(candidates.data(), candidates.size(), [&](size_t j)
+                                           { tmp.push_back(candidates[j]); });
+                if (libs.size() > 1)
+                    std::sort(tmp.begin(), tmp.end());
+                candidates.swap(tmp);
+            }
+            for (uint32_t term_id : query.excluded_terms)
+            {
+                const std::vector<uint32_t> *ids = index->getDocIds(term_id, shard);
+                if (ids)
+                    bs_posting_ops::subtract(candidates, ids->data(), ids->size());
+            }
 
-            if (start > end)
+            for (uint32_t id : candidates)
             {
-                LOG(Level::Warning, "内容不足，无法截取文章内容");
-                return "Fail to cut body, body is not enough";
+                // 跳过已经删除或者被新版本替换的文档
+                if (!index->isDocDeleted(id))
+                    hits.emplace_back(id, 0, 0);
+            }
+
+            // 候选文档ID递增，每个词的拉链只需要向前倍增查找
+            for (size_t i = 0; i < query.score_terms.size(); i++)
+            {
+                uint32_t term_id = query.score_terms[i];
+                const std::vector<uint32_t> *ids = index->getDocIds(term_id, shard);
+                if (!ids)
+                    continue;
+                // 只有高频词的查询使用高频词单独保存的倒排节点
+                const std::vector<bs_search_index::BackwardIndexElement> *postings = index->getBackwardIndexElement(term_id, shard);
+                const std::vector<bs_search_index::CommonPosting> *common = postings ? nullptr : index->getCommonPostings(term_id, shard);
+                uint64_t bit = termBit(i);
+                size_t j = 0;
+                for (auto &el : hits)
+                {
+                    j = bs_posting_ops::gallopTo(ids->data(), j, ids->size(), static_cast<uint32_t>(el.id));
+                    if (j == ids->size())
+                        break;
+                    if ((*ids)[j] == el.id)
+                    {
+                        el.weight += postings ? (*postings)[j].weight : (*common)[j].weight;
+                        el.term_mask |= bit;
+                    }
+                }
             }
 
-            // 左闭右闭区间
-            return std::string(body.substr(start, end - start + 1));
+            // 限定字段的词按照在该字段中出现的次数加权，候选文档一定出现在这些拉链中
+            for (size_t f = 0; f < bs_search_index::field_count; f++)
+            {
+                auto field = static_cast<bs_search_index::DocField>(f);
+                for (uint32_t term_id : query.field_terms[f])
+                {
+                    const std::vector<uint32_t> &ids = *index->getFieldDocIds(field, term_id, shard);
+                    const std::vector<uint16_t> &counts = index->getFieldCounts(field, term_id, shard);
+                    size_t j = 0;
+                    for (auto &el : hits)
+                    {
+                        j = bs_posting_ops::gallopTo(ids.data(), j, ids.size(), static_cast<uint32_t>(el.id));
+                        el.weight += counts[j] * bs_search_index::field_weight_per[f];
+                    }
+                }
+            }
+        }
+
+        // 没有必须包含的词：逐个词遍历拉链，把权重累加到稠密数组中，每个文档累加所有命中词的权重
+        // 指定了库时只累加拉链中属于这些库的文档
+        void collectAny(bs_search_index::SearchIndex *index, size_t shard, const ParsedQuery &query, const std::vector<const bs_bitmap::RoaringBitmap *> &libs,
+                        std::vector<SearchIndexElement> &hits)
+        {
+            size_t shard_num = index->getShardNum();
+            thread_local ScoreAccumulator acc;
+            acc.prepare(index->getDocCount() / shard_num + 1);
+
+            for (size_t i = 0; i < query.score_terms.size(); i++)
+            {
+                uint32_t term_id = query.score_terms[i];
+                uint64_t bit = termBit(i);
+                if (!libs.empty())
+                {
+                    const std::vector<uint32_t> *ids = index->getDocIds(term_id, shard);
+                    if (!ids)
+                        continue;
+                    const std::vector<bs_search_index::BackwardIndexElement> *postings = index->getBackwardIndexElement(term_id, shard);
+                    const std::vector<bs_search_index::CommonPosting> *common = postings ? nullptr : index->getCommonPostings(term_id, shard);
+                    for (const bs_bitmap::RoaringBitmap *docs : libs)
+                        docs->forEachContained(ids->data(), ids->size(), [&](size_t j)
+                                               { acc.add((*ids)[j] / shard_num, postings ? (*postings)[j].weight : (*common)[j].weight, bit); });
+                }
+                else if (const std::vector<bs_search_index::BackwardIndexElement> *postings = index->getBackwardIndexElement(term_id, shard))
+                {
+                    for (auto &bi : *postings)
+                        acc.add(static_cast<uint32_t>(bi.id / shard_num), bi.weight, bit);
+                }
+                else if (const std::vector<bs_search_index::CommonPosting> *common = index->getCommonPostings(term_id, shard))
+                {
+                    // 只有高频词的查询：高频词的文档ID和权重分开存放
+                    const std::vector<uint32_t> &ids = *index->getDocIds(term_id, shard);
+                    for (size_t j = 0; j < ids.size(); j++)
+                        acc.add(ids[j] / shard_num, (*common)[j].weight, bit);
+                }
+            }
+
+            // 标记命中的文档中包含-词的，没有命中的文档不需要处理
+            for (uint32_t term_id : query.excluded_terms)
+            {
+                const std::vector<uint32_t> *ids = index->getDocIds(term_id, shard);
+                if (!ids)
+                    continue;
+                for (uint32_t id : *ids)
+                {
+                    uint32_t slot = id / shard_num;
+                    if (acc.term_masks[slot] != 0)
+                        acc.term_masks[slot] |= excluded_bit;
+                }
+            }
+
+            for (uint32_t slot : acc.touched)
+            {
+                uint64_t id = static_cast<uint64_t>(slot) * shard_num + shard;
+                uint64_t mask = acc.term_masks[slot];
+                // 跳过被排除、已经删除或者被新版本替换的文档
+                if ((mask & excluded_bit) || index->isDocDeleted(id))
+                    continue;
+                hits.emplace_back(id, mask, acc.weights[slot]);
+            }
+            acc.reset();
+        }
+
+        // 合并各个分片的有序结果
+        static std::vector<SearchIndexElement> mergeResults(std::vector<std::vector<SearchIndexElement>> &partial, size_t top_k)
+        {
+            if (partial.size() == 1)
+                return std::move(partial[0]);
+
+            size_t total = 0;
+            for (auto &p : partial)
+                total += p.size();
+
+            std::vector<SearchIndexElement> results;
+            results.reserve(total);
+            for (auto &p : partial)
+            {
+                size_t mid = results.size();
+                std::move(p.begin(), p.end(), std::back_inserter(results));
+                std::inplace_merge(results.begin(), results.begin() + mid, results.end(), compareResult);
+            }
+
+            if (top_k > 0 && top_k < results.size())
+                results.resize(top_k);
+            return results;
+        }
+
+        // 后台重新加载线程
+        void reloadLoop()
+        {
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(reload_mtx_);
+                    reload_cond_.wait(lock, [&]()
+                                      { return reload_requested_ || stop_; });
+                    if (stop_)
+                        return;
+                    reload_requested_ = false;
+                }
+
+                reloading_.store(true, std::memory_order_relaxed);
+                reload();
+                reloading_.store(false, std::memory_order_relaxed);
+            }
         }
 
     private:
-        bs_search_index::SearchIndex *search_index_;
-        cppjieba::Jieba jieba_;
+        std::filesystem::path raw_path_;                               // 文本文件路径
+        size_t shard_num_;                                             // 索引分片数
+        bool positions_enabled_;                                       // 索引是否记录位置信息
+        bs_search_index::PruneOptions prune_;                          // 建立索引时的剪枝选项
+        bs_thread_pool::ThreadPool pool_;                              // 分片查询线程池
+        std::atomic<bs_search_index::SearchIndex *> search_index_;     // 当前使用的索引
+        bs_tokenizer::Tokenizer tokenizer_;                            // 分词器，与索引共用词典
+
+        std::mutex swap_mtx_;                    // 保证同一时间只有一次重新加载
+        std::mutex reload_mtx_;                  // 保护重新加载请求
+        std::condition_variable reload_cond_;
+        bool reload_requested_;
+        bool stop_;
+        std::atomic<bool> reloading_;
+        std::atomic<uint64_t> reload_count_;
+        std::atomic<uint64_t> query_cache_hits_;   // 查询切分缓存命中次数
+        std::atomic<uint64_t> query_cache_misses_; // 查询切分缓存未命中次数
+        std::thread reload_thread_;
     };
 }
 
@@ -3,33 +3,80 @@
 
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <cstdint>
+#include <atomic>
 #include <fstream>
 #include <string_view>
-#include <mutex>
+#include <algorithm>
+#include <cctype>
 #include <boost/algorithm/string.hpp>
 #include <boost_search/base/public_data.h>
+#include <boost_search/base/manifest.h>
 #include <boost_search/base/log.h>
 #include <boost_search/utils/common_op.h>
-#include <boost_search/include/cppjieba/Jieba.hpp> // 引入Jieba分词
+#include <boost_search/search/term_dictionary.h>
+#include <boost_search/search/suggest_index.h>
+#include <boost_search/search/tokenizer.h>
+#include <boost_search/search/forward_index.h>
+#include <boost_search/search/bitmap.h>
 
 namespace bs_search_index
 {
     using namespace bs_log_system;
 
-    // 当前筛选出的文档信息
-    struct SelectedDocInfo
-    {
-        struct bs_public_data::ResultData rd;
-        uint64_t id;
-    };
+    // 没有位置信息
+    const uint32_t no_positions = UINT32_MAX;
+    // 词没有出现在正文中
+    const uint32_t no_body_offset = UINT32_MAX;
+    // 标题与正文之间的位置间隔，避免短语和邻近度跨越字段匹配
+    const uint32_t field_position_gap = 64;
 
     // 倒排索引时当前关键字的信息
     struct BackwardIndexElement
     {
-        uint64_t id;      // 文档ID
-        std::string word; // 关键字
-        int weight;       // 权重信息
+        uint64_t id;                         // 文档ID
+        int weight;                          // 权重信息
+        uint32_t pos_offset = no_positions;  // 位置信息在分片positions中的偏移
+        uint32_t body_offset = no_body_offset; // 词在正文中第一次出现的字节偏移，用于截取摘要
+    };
+
+    // 高频词的倒排节点，只保留权重和正文偏移，文档ID在IndexShard::doc_ids中
+    struct CommonPosting
+    {
+        int weight;           // 权重信息
+        uint32_t body_offset; // 词在正文中第一次出现的字节偏移，用于截取摘要
+    };
+
+    // 可以单独限定查询的字段，对应查询语法title:和url:
+    enum DocField
+    {
+        field_title = 0,
+        field_url,
+        field_count
+    };
+
+    // 限定字段查询时词每次出现的权重，标题与全文打分中的标题权重相同
+    const int field_weight_per[field_count] = {10, 1};
+
+    // 单个字段的倒排拉链，只记录文档ID和词在该字段中出现的次数，比全文拉链小得多
+    struct FieldPostings
+    {
+        std::vector<std::vector<uint32_t>> doc_ids; // 下标为词编号，文档ID递增
+        std::vector<std::vector<uint16_t>> counts;  // 与doc_ids一一对应，超过UINT16_MAX时按照UINT16_MAX计
+    };
+
+    // 倒排索引分片，文档按照ID对分片数取模划分，每个分片只包含自己文档的倒排拉链
+    // 所有分片共用同一个词典，倒排拉链按照词编号存放，同一条拉链中文档ID递增
+    struct IndexShard
+    {
+        std::vector<std::vector<BackwardIndexElement>> postings; // 倒排索引结果，下标为词编号
+        std::vector<std::vector<uint32_t>> doc_ids;              // 与postings一一对应的文档ID，连续存放便于求交
+        std::vector<std::vector<CommonPosting>> common_postings; // 高频词不保留postings，只保留与doc_ids一一对应的权重和正文偏移
+        FieldPostings fields[field_count];                       // 标题和URL各自的倒排拉链，用于限定字段的查询
+        std::string positions;                                   // 压缩的位置信息，只有短语和邻近度查询才会解码
+        size_t doc_cnt = 0;                                      // 分片中的文档数
+        size_t posting_cnt = 0;                                  // 分片中的倒排节点数
     };
 
     // 频率结构
@@ -37,73 +84,384 @@ namespace bs_search_index
     {
         int title_cnt;
         int body_cnt;
+        uint32_t body_offset = no_body_offset; // 在正文中第一次出现的字节偏移
+        std::vector<uint32_t> positions;      // 词在文档中的位置，不统计空白
+    };
+
+    // 包含字母、数字或者非ASCII字符的词，摘要中只高亮这类词
+    inline bool isWordToken(std::string_view word)
+    {
+        for (unsigned char c : word)
+        {
+            if (c >= 0x80 || std::isalnum(c))
+                return true;
+        }
+        return false;
+    }
+
+    // 空白词不参与位置编号
+    inline bool isBlankToken(std::string_view word)
+    {
+        for (unsigned char c : word)
+        {
+            if (!std::isspace(c))
+                return false;
+        }
+        return true;
+    }
+
+    // 根据去掉前缀之后的URL得到文档所属的库（转为小写）：第一级目录名，没有目录时为去掉扩展名的文件名
+    // 例如/boost_asio/reference.html -> boost_asio，/array.html -> array
+    inline std::string libraryOfUrlPath(std::string_view path)
+    {
+        while (!path.empty() && path.front() == '/')
+            path.remove_prefix(1);
+        size_t end = path.find('/');
+        if (end == std::string_view::npos)
+            end = path.find('.');
+        std::string name(path.substr(0, end));
+        bs_tokenizer::asciiToLower(&name[0], name.size());
+        return name;
+    }
+
+    // 默认的英文停用词
+    inline const std::vector<std::string> &defaultStopWords()
+    {
+        static const std::vector<std::string> words = {
+            "a", "an", "and", "are", "as", "at", "be", "by", "for", "from", "if", "in",
+            "is", "it", "of", "on", "or", "that", "the", "this", "to", "was", "with"};
+        return words;
+    }
+
+    /**
+     * 建立索引时的剪枝选项
+     * 空白和标点不建立倒排拉链，只占用位置编号；
+     * 停用词以及文档频率超过上限的词作为高频词，只保留文档ID、权重和正文偏移（不保存完整的倒排节点和位置信息），
+     * 查询中还有其他词时高频词不参与打分，也不参与短语和邻近度计算
+     */
+    struct PruneOptions
+    {
+        std::vector<std::string> stop_words = defaultStopWords(); // 停用词
+        double max_doc_freq_ratio = 0.5;                         // 包含该词的文档数超过总文档数的这一比例时作为高频词，不大于0时不限制
+        size_t min_doc_count = 100;                               // 文档数少于该值时不按照文档频率剪枝
     };
 
+    // 位置信息编码：个数，之后为相邻位置的差值，均使用变长整数
+    inline void encodeVarint(std::string &out, uint32_t v)
+    {
+        while (v >= 0x80)
+        {
+            out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    inline uint32_t decodeVarint(const char *&p)
+    {
+        uint32_t v = 0;
+        int shift = 0;
+        while (true)
+        {
+            unsigned char c = static_cast<unsigned char>(*p++);
+            v |= static_cast<uint32_t>(c & 0x7F) << shift;
+            if (c < 0x80)
+                return v;
+            shift += 7;
+        }
+    }
+
+    inline void encodePositions(std::string &out, const std::vector<uint32_t> &positions)
+    {
+        encodeVarint(out, static_cast<uint32_t>(positions.size()));
+        uint32_t prev = 0;
+        for (uint32_t p : positions)
+        {
+            encodeVarint(out, p - prev);
+            prev = p;
+        }
+    }
+
+    // 跳过一组编码的位置信息，返回之后的位置
+    inline const char *skipPositions(const char *p)
+    {
+        uint32_t cnt = decodeVarint(p);
+        for (uint32_t i = 0; i < cnt; i++)
+            decodeVarint(p);
+        return p;
+    }
+
+    inline void decodePositions(const char *p, std::vector<uint32_t> &out)
+    {
+        uint32_t cnt = decodeVarint(p);
+        out.resize(cnt);
+        uint32_t prev = 0;
+        for (uint32_t i = 0; i < cnt; i++)
+        {
+            prev += decodeVarint(p);
+            out[i] = prev;
+        }
+    }
+
+    // 一份完整的索引，建立完成后只读
+    // 重新加载时创建新的索引对象替换旧的索引，见SearchEngine
     class SearchIndex
     {
     private:
         static const int title_weight_per = 10;
         static const int body_weight_per = 1;
 
-        // 私有构造函数
+        // 禁用拷贝和赋值，分词器不能拷贝，复制索引使用copyIndexFrom
+        SearchIndex(const SearchIndex &si) = delete;
+        SearchIndex& operator=(SearchIndex &si) = delete;
+        SearchIndex(SearchIndex &&si) = delete;
+
+    public:
         SearchIndex()
+            : shards_(1)
         {
+            setPruneOptions(PruneOptions());
         }
 
-        // 禁用拷贝和赋值
-        SearchIndex(const SearchIndex &si) = delete;
-        SearchIndex& operator=(SearchIndex &si) = delete;
-        SearchIndex(SearchIndex &&si) = delete;
+        // 设置分片数，需要在建立索引之前设置，默认只有一个分片
+        void setShardNum(size_t shard_num)
+        {
+            if (shard_num == 0)
+                shard_num = 1;
+            shards_.assign(shard_num, IndexShard());
+        }
 
-        static SearchIndex *si;
+        size_t getShardNum() const
+        {
+            return shards_.size();
+        }
 
-    public:
-        // 获取单例对象
-        static SearchIndex *getSearchIndexInstance()
+        const IndexShard &getShard(size_t shard) const
         {
-            if (!si)
-            {
-                // 加锁
-                mtx_.lock();
-                if (!si)
-                    si = new SearchIndex();
-                mtx_.unlock();
-            }
+            return shards_[shard];
+        }
 
-            return si;
+        // 复制其他索引的全部内容，用于在新的索引对象上增量更新
+        void copyIndexFrom(const SearchIndex &other)
+        {
+            forward_index_ = other.forward_index_;
+            shards_ = other.shards_;
+            positions_enabled_ = other.positions_enabled_;
+            dict_ = other.dict_;
+            dict_version_ = other.dict_version_;
+            suggest_ = other.suggest_;
+            prune_ = other.prune_;
+            stop_words_ = other.stop_words_;
+            common_ = other.common_;
+            libraries_ = other.libraries_;
+            library_ids_ = other.library_ids_;
+            library_docs_ = other.library_docs_;
+            generation_ = other.generation_;
+            raw_offset_ = other.raw_offset_;
+            deleted_cnt_ = other.deleted_cnt_;
         }
 
-        // 获取正排索引结果
-        SelectedDocInfo *getForwardIndexDocInfo(uint64_t id)
+        // 获取正排索引中的文档数（包括已删除的文档）
+        size_t getDocCount() const
         {
-            if (id < 0 || id > forward_index_.size())
+            return forward_index_.size();
+        }
+
+        // 获取正排索引，按照文档ID读取标题、正文和URL
+        const bs_forward_index::ForwardIndex &getForwardIndex() const
+        {
+            return forward_index_;
+        }
+
+        // 获取文档正文，返回值在当前线程下一次读取正文之前有效，不存在的文档返回空串
+        std::string_view getBody(uint64_t id) const
+        {
+            if (id >= forward_index_.size())
             {
                 LOG(Level::Warning, "不存在指定的文档ID");
-                return nullptr;
+                return std::string_view();
             }
 
-            return &forward_index_[id];
+            return forward_index_.getBody(id);
         }
 
-        // 获取倒排索引结果
-        std::vector<BackwardIndexElement> *getBackwardIndexElement(const std::string &keyword)
+        // 获取倒排索引结果，只包含指定分片中的文档
+        std::vector<BackwardIndexElement> *getBackwardIndexElement(const std::string &keyword, size_t shard = 0)
         {
-            auto pos = backward_index_.find(keyword);
-            if (pos == backward_index_.end())
+            uint32_t term_id = dict_.find(keyword);
+            if (term_id == bs_term_dictionary::npos)
             {
                 LOG(Level::Warning, "不存在对应的关键字");
                 return nullptr;
             }
 
-            return &backward_index_[keyword];
+            return getBackwardIndexElement(term_id, shard);
+        }
+
+        // 根据词编号获取倒排索引结果，分片中没有包含该词的文档或者该词是高频词时返回nullptr
+        std::vector<BackwardIndexElement> *getBackwardIndexElement(uint32_t term_id, size_t shard)
+        {
+            auto &postings = shards_[shard].postings;
+            if (term_id >= postings.size() || postings[term_id].empty())
+                return nullptr;
+            return &postings[term_id];
+        }
+
+        // 设置是否记录词的位置信息，需要在建立索引之前设置，默认记录
+        // 不记录位置信息时不支持短语查询和邻近度加权
+        void setPositionsEnabled(bool enabled)
+        {
+            positions_enabled_ = enabled;
+            dict_version_ = nextDictVersion();
+        }
+
+        bool hasPositions() const
+        {
+            return positions_enabled_;
+        }
+
+        // 设置剪枝选项，需要在建立索引之前设置
+        void setPruneOptions(const PruneOptions &options)
+        {
+            prune_ = options;
+            stop_words_.clear();
+            for (auto word : prune_.stop_words)
+            {
+                boost::to_lower(word);
+                stop_words_.insert(std::move(word));
+            }
+        }
+
+        // 是否为高频词：没有位置信息，查询中还有其他词时不参与打分
+        bool isCommonTerm(uint32_t term_id) const
+        {
+            return term_id < common_.size() && common_[term_id];
+        }
+
+        // 高频词的个数
+        size_t getCommonTermCount() const
+        {
+            return std::count(common_.begin(), common_.end(), 1);
+        }
+
+        // 库的数量，只有以g_url_to_concat开头的URL属于某个库，见libraryOfUrlPath
+        size_t getLibraryCount() const
+        {
+            return libraries_.size();
+        }
+
+        const std::string &getLibraryName(uint32_t lib) const
+        {
+            return libraries_[lib];
+        }
+
+        // 属于该库的文档ID，包括已经删除的文档
+        const bs_bitmap::RoaringBitmap &getLibraryDocs(uint32_t lib) const
+        {
+            return library_docs_[lib];
+        }
+
+        // 根据库名（小写）查找属于该库的文档ID，不存在时返回nullptr
+        const bs_bitmap::RoaringBitmap *findLibrary(const std::string &name) const
+        {
+            auto pos = library_ids_.find(name);
+            if (pos == library_ids_.end())
+                return nullptr;
+            return &library_docs_[pos->second];
+        }
+
+        // 词典版本，词编号改变（重新生成词典、清空索引）、高频词集合改变或者位置信息开关改变时取一个新值
+        // 所有索引实例共用同一个计数器，不会重复，按照词编号缓存的查询以此判断是否仍然有效
+        uint64_t getDictionaryVersion() const
+        {
+            return dict_version_;
+        }
+
+        // 获取词在文档中的所有位置（升序），文档不包含该词或者没有位置信息时返回false
+        bool getPositions(uint32_t term_id, size_t shard, uint64_t doc_id, std::vector<uint32_t> &out) const
+        {
+            const IndexShard &s = shards_[shard];
+            if (term_id >= s.postings.size())
+                return false;
+            const auto &list = s.postings[term_id];
+            auto pos = std::lower_bound(list.begin(), list.end(), doc_id, [](const BackwardIndexElement &b, uint64_t id)
+                                        { return b.id < id; });
+            if (pos == list.end() || pos->id != doc_id || pos->pos_offset == no_positions)
+                return false;
+
+            decodePositions(s.positions.data() + pos->pos_offset, out);
+            return true;
+        }
+
+        // 高频词的倒排节点，与getDocIds返回的文档ID一一对应；不是高频词或者分片中没有包含该词的文档时返回nullptr
+        const std::vector<CommonPosting> *getCommonPostings(uint32_t term_id, size_t shard) const
+        {
+            const auto &common = shards_[shard].common_postings;
+            if (term_id >= common.size() || common[term_id].empty())
+                return nullptr;
+            return &common[term_id];
+        }
+
+        // 根据词编号获取有序的文档ID序列，与getBackwardIndexElement返回的拉链一一对应，高频词同样存在
+        const std::vector<uint32_t> *getDocIds(uint32_t term_id, size_t shard) const
+        {
+            const auto &doc_ids = shards_[shard].doc_ids;
+            if (term_id >= doc_ids.size() || doc_ids[term_id].empty())
+                return nullptr;
+            return &doc_ids[term_id];
+        }
+
+        // 获取指定字段中包含该词的文档ID，没有时返回nullptr
+        const std::vector<uint32_t> *getFieldDocIds(DocField field, uint32_t term_id, size_t shard) const
+        {
+            const auto &doc_ids = shards_[shard].fields[field].doc_ids;
+            if (term_id >= doc_ids.size() || doc_ids[term_id].empty())
+                return nullptr;
+            return &doc_ids[term_id];
+        }
+
+        // 与getFieldDocIds一一对应的出现次数
+        const std::vector<uint16_t> &getFieldCounts(DocField field, uint32_t term_id, size_t shard) const
+        {
+            return shards_[shard].fields[field].counts[term_id];
+        }
+
+        // 获取词在文档正文中第一次出现的字节偏移，不存在时返回no_body_offset
+        uint32_t getBodyOffset(uint32_t term_id, uint64_t doc_id) const
+        {
+            size_t shard = doc_id % shards_.size();
+            const std::vector<uint32_t> *ids = getDocIds(term_id, shard);
+            if (!ids)
+                return no_body_offset;
+            auto pos = std::lower_bound(ids->begin(), ids->end(), static_cast<uint32_t>(doc_id));
+            if (pos == ids->end() || *pos != doc_id)
+                return no_body_offset;
+            const auto &postings = shards_[shard].postings[term_id];
+            if (postings.empty())
+                return shards_[shard].common_postings[term_id][pos - ids->begin()].body_offset;
+            return postings[pos - ids->begin()].body_offset;
+        }
+
+        // 获取词典，可用于前缀查找，词编号按照字典序排列
+        const bs_term_dictionary::TermDictionary &getTermDictionary() const
+        {
+            return dict_;
+        }
+
+        // 获取前缀补全索引
+        const bs_suggest_index::SuggestIndex &getSuggestIndex() const
+        {
+            return suggest_;
         }
 
         // 构建索引
-        bool buildIndex()
+        // 默认读取解析程序生成的文本文件，也可以指定其他文本文件（例如基准测试使用的固定语料）
+        // 文本文件存在对应的清单时，不在清单中的文档标记为已删除
+        bool buildIndex(const std::filesystem::path &raw_path = bs_public_data::g_rawfile_path)
         {
             LOG(Level::Info, "开始建立索引");
             // 以二进制方式读取文本文件中的内容
-            std::fstream in(bs_public_data::g_rawfile_path, std::ios::in | std::ios::binary);
+            std::fstream in(raw_path, std::ios::in | std::ios::binary);
 
             if (!in.is_open())
             {
@@ -111,22 +469,131 @@ namespace bs_search_index
                 return false;
             }
 
-            // 读取每一个ResultData对象
+            bs_manifest::Manifest manifest;
+            bool has_manifest = manifest.load(bs_manifest::getManifestPath(raw_path));
+            generation_ = has_manifest ? manifest.getGeneration() : 0;
+
+            raw_offset_ = readRecords(in);
+            forward_index_.seal();
+            freezeDictionary();
+            markCommonTerms();
+            applyTombstones(has_manifest ? &manifest : nullptr);
+            buildSuggestIndex();
+            LOG(Level::Warning, "建立索引完成，词数：{}，词典大小：{}字节，高频词：{}，正文：{}字节，压缩后：{}字节，库：{}",
+                dict_.size(), dict_.memoryBytes(), getCommonTermCount(), forward_index_.getBodyStore().rawBytes(), forward_index_.getBodyStore().memoryBytes(), libraries_.size());
+            for (size_t i = 0; i < shards_.size() && shards_.size() > 1; i++)
+                LOG(Level::Info, "分片{}：文档数：{}，倒排节点数：{}，位置信息：{}字节", i, shards_[i].doc_cnt, shards_[i].posting_cnt, shards_[i].positions.size());
+
+            return true;
+        }
+
+        // 增量更新索引：读取文本文件中新追加的记录，并根据清单更新已删除的文档
+        // 文本文件被全量解析重新生成时返回false，需要重新建立索引
+        // 非线程安全，不能与搜索同时进行，正在使用的索引需要先复制再更新
+        bool applyDelta(const std::filesystem::path &raw_path = bs_public_data::g_rawfile_path)
+        {
+            bs_manifest::Manifest manifest;
+            if (!manifest.load(bs_manifest::getManifestPath(raw_path)))
+            {
+                LOG(Level::Warning, "读取解析清单失败，无法增量更新索引");
+                return false;
+            }
+
+            if (manifest.getGeneration() != generation_)
+            {
+                LOG(Level::Warning, "文本文件已经重新生成，需要重新建立索引");
+                return false;
+            }
+
+            std::fstream in(raw_path, std::ios::in | std::ios::binary);
+            if (!in.is_open())
+            {
+                LOG(Level::Warning, "打开文本文件失败");
+                return false;
+            }
+            in.seekg(raw_offset_);
+
+            size_t old_size = forward_index_.size();
+            size_t old_deleted = deleted_cnt_;
+            raw_offset_ += readRecords(in);
+            forward_index_.seal();
+            freezeDictionary();
+            markCommonTerms();
+            applyTombstones(&manifest);
+            buildSuggestIndex();
+
+            LOG(Level::Info, "增量更新索引完成，新增文档：{}，新增删除：{}", forward_index_.size() - old_size, deleted_cnt_ - old_deleted);
+            return true;
+        }
+
+        // 判断文本文件能否在当前索引的基础上增量更新
+        bool canApplyDelta(const std::filesystem::path &raw_path = bs_public_data::g_rawfile_path) const
+        {
+            bs_manifest::Manifest manifest;
+            if (!manifest.load(bs_manifest::getManifestPath(raw_path)))
+                return false;
+            return generation_ != 0 && manifest.getGeneration() == generation_;
+        }
+
+        // 判断文档是否已经删除
+        bool isDocDeleted(uint64_t id) const
+        {
+            return id >= forward_index_.size() || forward_index_.isDeleted(id);
+        }
+
+        // 获取已经删除的文档数
+        size_t getDeletedCount() const
+        {
+            return deleted_cnt_;
+        }
+
+        // 清空已经建立的索引
+        void clear()
+        {
+            forward_index_.clear();
+            setShardNum(shards_.size());
+            dict_ = bs_term_dictionary::TermDictionary();
+            dict_version_ = nextDictVersion();
+            suggest_ = bs_suggest_index::SuggestIndex();
+            common_.clear();
+            libraries_.clear();
+            library_ids_.clear();
+            library_docs_.clear();
+            pending_terms_.clear();
+            word_cnt_.clear();
+            generation_ = 0;
+            raw_offset_ = 0;
+            deleted_cnt_ = 0;
+        }
+
+    private:
+        // 从当前位置开始读取每一个ResultData对象建立索引，返回读取的字节数
+        // 文档ID与记录所在的行号保持一致，无法解析的行同样占用一个ID并标记为已删除
+        uint64_t readRecords(std::istream &in)
+        {
             std::string line;
+            std::vector<std::string_view> fields;
+            uint64_t bytes = 0;
             int count = 0;
             while (getline(in, line))
             {
-                // 构建正排索引
-                struct SelectedDocInfo *s = buildForwardIndex(line);
+                bytes += line.size() + bs_public_data::g_html_sep.size();
 
-                if (!s)
+                // 构建正排索引，字段引用line中的内容
+                fields.clear();
+                bs_common_op::CommonOp::split(fields, line, bs_public_data::g_rd_sep);
+                if (fields.size() != 3)
                 {
-                    LOG(Level::Warning, "构建正排索引失败");
+                    LOG(Level::Warning, "无法读取元信息，构建正排索引失败");
+                    forward_index_.appendPlaceholder();
                     continue;
                 }
+                // 注意字段顺序：标题、正文、URL
+                uint64_t id = forward_index_.append(fields[0], fields[1], fields[2]);
+                addToLibrary(id);
 
-                // 构建倒排索引
-                bool flag = buildBackwardIndex(*s);
+                // 构建倒排索引，URL只切分去掉前缀之后的部分
+                bool flag = buildBackwardIndex(id, fields[0], fields[1], forward_index_.getUrlPath(id));
 
                 if (!flag)
                 {
@@ -138,86 +605,346 @@ namespace bs_search_index
                 if (count % 50 == 0)
                     LOG(Level::Info, "已经建立：{}", count);
             }
-            LOG(Level::Warning, "建立索引完成");
 
-            return true;
+            return bytes;
         }
 
-    private:
-        SelectedDocInfo *buildForwardIndex(std::string &line)
+        // 获取词编号，词典中没有的新词暂存在pending_terms_中，编号接在词典之后
+        uint32_t getTermId(const std::string &word)
+        {
+            uint32_t term_id = dict_.find(word);
+            if (term_id != bs_term_dictionary::npos)
+                return term_id;
+            auto ret = pending_terms_.emplace(word, dict_.size() + pending_terms_.size());
+            return ret.first->second;
+        }
+
+        // 将新词合并进词典，重新按照字典序编号，并同步调整各个分片中倒排拉链的位置
+        void freezeDictionary()
+        {
+            if (pending_terms_.empty())
+                return;
+
+            uint32_t old_size = dict_.size();
+            uint32_t total = old_size + pending_terms_.size();
+            std::vector<std::string_view> terms(total);
+            for (uint32_t i = 0; i < old_size; i++)
+                terms[i] = dict_.getTerm(i);
+            for (const auto &pair : pending_terms_)
+                terms[pair.second] = pair.first;
+
+            // order[新编号] = 旧编号
+            std::vector<uint32_t> order(total);
+            for (uint32_t i = 0; i < total; i++)
+                order[i] = i;
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+                      { return terms[a] < terms[b]; });
+
+            std::vector<std::string_view> sorted_terms(total);
+            for (uint32_t i = 0; i < total; i++)
+                sorted_terms[i] = terms[order[i]];
+            bs_term_dictionary::TermDictionary dict;
+            dict.build(sorted_terms);
+
+            for (auto &shard : shards_)
+            {
+                reorderByTerm(shard.postings, order);
+                reorderByTerm(shard.doc_ids, order);
+                reorderByTerm(shard.common_postings, order);
+                for (auto &field : shard.fields)
+                {
+                    reorderByTerm(field.doc_ids, order);
+                    reorderByTerm(field.counts, order);
+                }
+            }
+
+            // sorted_terms引用了旧词典和pending_terms_中的字符串，新词典建立完成后才能释放
+            dict_ = std::move(dict);
+            dict_version_ = nextDictVersion();
+            pending_terms_.clear();
+        }
+
+        // 按照新的词编号重新排列拉链，order[新编号] = 旧编号
+        template <class List>
+        static void reorderByTerm(std::vector<List> &lists, const std::vector<uint32_t> &order)
+        {
+            lists.resize(order.size());
+            std::vector<List> sorted(order.size());
+            for (uint32_t i = 0; i < order.size(); i++)
+                sorted[i] = std::move(lists[order[i]]);
+            lists = std::move(sorted);
+        }
+
+        static uint64_t nextDictVersion()
+        {
+            static std::atomic<uint64_t> version(0);
+            return version.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+
+        // 根据清单标记已删除的文档，没有清单时所有解析成功的文档都有效
+        void applyTombstones(const bs_manifest::Manifest *manifest)
         {
-            std::vector<std::string> out_string;
+            std::vector<bool> live(forward_index_.size(), manifest == nullptr);
+            if (manifest)
+            {
+                for (const auto &pair : manifest->getEntries())
+                {
+                    if (pair.second.doc_id < live.size())
+                        live[pair.second.doc_id] = true;
+                }
+            }
 
-            bs_common_op::CommonOp::split(out_string, line, bs_public_data::g_rd_sep);
+            deleted_cnt_ = 0;
+            for (uint64_t id = 0; id < forward_index_.size(); id++)
+            {
+                // 解析失败的占位文档始终保持删除状态
+                forward_index_.setDeleted(id, !live[id]);
+                deleted_cnt_ += forward_index_.isDeleted(id);
+            }
+        }
 
-            if (out_string.size() != 3)
+        // 标记高频词：停用词、文档频率超过上限的词，以及之前已经标记的词（增量更新后保持不变），
+        // 高频词的拉链只在查询中没有其他词时使用，只保留文档ID、权重和正文偏移，去掉完整的postings和位置信息，
+        // 然后重新压缩各个分片的位置信息
+        void markCommonTerms()
+        {
+            uint32_t n = dict_.size();
+            std::vector<uint8_t> old_common;
+            old_common.swap(common_);
+            common_.assign(n, 0);
+            for (const auto &word : stop_words_)
             {
-                LOG(Level::Warning, "无法读取元信息");
-                return nullptr;
+                uint32_t term_id = dict_.find(word);
+                if (term_id != bs_term_dictionary::npos)
+                    common_[term_id] = 1;
+            }
+
+            std::vector<uint32_t> df(n, 0);
+            for (const auto &shard : shards_)
+            {
+                for (uint32_t i = 0; i < shard.doc_ids.size(); i++)
+                    df[i] += shard.doc_ids[i].size();
+                for (uint32_t i = 0; i < shard.common_postings.size(); i++)
+                    common_[i] |= !shard.common_postings[i].empty();
+            }
+
+            size_t doc_cnt = forward_index_.size();
+            if (prune_.max_doc_freq_ratio > 0 && doc_cnt >= prune_.min_doc_count)
+            {
+                for (uint32_t i = 0; i < n; i++)
+                {
+                    if (df[i] > prune_.max_doc_freq_ratio * doc_cnt)
+                        common_[i] = 1;
+                }
             }
 
-            SelectedDocInfo sd;
-            // 注意填充顺序
-            sd.rd.title = out_string[0];
-            sd.rd.body = out_string[1];
-            sd.rd.url = out_string[2];
-            // 先设置id时直接使用正排索引数组长度
-            sd.id = forward_index_.size();
-            // 再添加SelectedDocInfo对象
-            forward_index_.push_back(std::move(sd));
+            // 词典没有新词时也可能有词变为高频词，缓存的查询中记录了是否为高频词，需要失效
+            if (common_ != old_common)
+                dict_version_ = nextDictVersion();
+
+            // 高频词的postings（新标记的词是全部文档，之前已经标记的词是增量更新新增的文档）追加到common_postings
+            for (auto &shard : shards_)
+            {
+                shard.common_postings.resize(shard.postings.size());
+                for (uint32_t i = 0; i < shard.postings.size(); i++)
+                {
+                    auto &list = shard.postings[i];
+                    if (!common_[i] || list.empty())
+                        continue;
+                    auto &common = shard.common_postings[i];
+                    common.reserve(common.size() + list.size());
+                    for (const auto &bi : list)
+                        common.push_back({bi.weight, bi.body_offset});
+                    common.shrink_to_fit();
+                    std::vector<BackwardIndexElement>().swap(list);
+                }
+            }
 
-            return &forward_index_.back();
+            if (!positions_enabled_)
+                return;
+            for (auto &shard : shards_)
+            {
+                size_t old_bytes = shard.positions.size();
+                std::string positions;
+                positions.reserve(old_bytes);
+                for (uint32_t i = 0; i < shard.postings.size(); i++)
+                {
+                    for (auto &bi : shard.postings[i])
+                    {
+                        if (bi.pos_offset == no_positions)
+                            continue;
+                        const char *begin = shard.positions.data() + bi.pos_offset;
+                        bi.pos_offset = static_cast<uint32_t>(positions.size());
+                        positions.append(begin, skipPositions(begin));
+                    }
+                }
+                positions.shrink_to_fit();
+                shard.positions = std::move(positions);
+            }
+        }
+
+        // 统计每个词在未删除文档中的文档频率，建立前缀补全索引
+        void buildSuggestIndex()
+        {
+            std::vector<uint32_t> df(dict_.size(), 0);
+            for (const auto &shard : shards_)
+            {
+                for (size_t i = 0; i < shard.doc_ids.size(); i++)
+                {
+                    for (uint32_t id : shard.doc_ids[i])
+                        df[i] += !forward_index_.isDeleted(id);
+                }
+            }
+            suggest_.build(dict_, std::move(df));
         }
 
         // 构建倒排索引
-        bool buildBackwardIndex(SelectedDocInfo &sd)
+        bool buildBackwardIndex(uint64_t id, std::string_view title, std::string_view body, std::string_view url)
         {
             word_cnt_.clear();
 
             // 统计标题中关键字出现的次数
+            // 位置按照分词结果的顺序编号，标题在前，正文在后
+            uint32_t position = 0;
             std::vector<std::string> title_words;
-            jieba_.CutForSearch(sd.rd.title, title_words);
+            tokenizer_.cutForSearch(title, title_words);
             for (auto &tw : title_words)
             {
-                // 忽略大小写
-                boost::to_lower(tw);
-                word_cnt_[tw].title_cnt++;
+                // 分词结果已经转为小写，忽略大小写
+                // 空白和标点不建立索引，标点仍然占用位置编号，短语匹配时作为间隔
+                if (!isWordToken(tw))
+                {
+                    if (positions_enabled_ && !isBlankToken(tw))
+                        position++;
+                    continue;
+                }
+                WordCount &wc = word_cnt_[tw];
+                wc.title_cnt++;
+                if (positions_enabled_)
+                    wc.positions.push_back(position++);
             }
 
-            // 统计内容中关键字出现的次数
-            std::vector<std::string> body_words;
-            jieba_.CutForSearch(sd.rd.body, body_words);
+            // 统计内容中关键字出现的次数，同时记录第一次出现的字节偏移
+            position += field_position_gap;
+            std::vector<cppjieba::Word> body_words;
+            tokenizer_.cutForSearch(body, body_words);
             for (auto &bw : body_words)
             {
-                boost::to_lower(bw);
-                word_cnt_[bw].body_cnt++;
+                if (!isWordToken(bw.word))
+                {
+                    if (positions_enabled_ && !isBlankToken(bw.word))
+                        position++;
+                    continue;
+                }
+                WordCount &wc = word_cnt_[bw.word];
+                wc.body_cnt++;
+                if (wc.body_offset == no_body_offset)
+                    wc.body_offset = bw.offset;
+                if (positions_enabled_)
+                    wc.positions.push_back(position++);
             }
 
             // 遍历关键字哈希表获取关键字填充对应的倒排索引节点
+            IndexShard &shard = shards_[id % shards_.size()];
+            shard.doc_cnt++;
+            shard.posting_cnt += word_cnt_.size();
             for (auto &word : word_cnt_)
             {
                 BackwardIndexElement b;
-                b.id = sd.id;
-                b.word = word.first;
+                b.id = id;
                 // 权重统计按照公式计算
                 b.weight = word.second.title_cnt * title_weight_per + word.second.body_cnt * body_weight_per;
+                b.body_offset = word.second.body_offset;
+                // 停用词不保存位置信息
+                if (!word.second.positions.empty() && !stop_words_.count(word.first))
+                {
+                    b.pos_offset = static_cast<uint32_t>(shard.positions.size());
+                    encodePositions(shard.positions, word.second.positions);
+                }
 
-                backward_index_[b.word].push_back(std::move(b));
+                uint32_t term_id = getTermId(word.first);
+                if (term_id >= shard.postings.size())
+                {
+                    shard.postings.resize(term_id + 1);
+                    shard.doc_ids.resize(term_id + 1);
+                }
+                shard.postings[term_id].push_back(std::move(b));
+                // 文档ID按照32位存放，单个索引的文档数不超过UINT32_MAX
+                shard.doc_ids[term_id].push_back(static_cast<uint32_t>(id));
+
+                // 出现在标题中的词同时加入标题拉链
+                if (word.second.title_cnt > 0)
+                    addFieldPosting(shard.fields[field_title], term_id, id, word.second.title_cnt);
+            }
+
+            // URL中的词只建立URL拉链，不参与全文打分
+            std::vector<std::string> url_words;
+            tokenizer_.cutForSearch(url, url_words);
+            url_words.erase(std::remove_if(url_words.begin(), url_words.end(), [](const std::string &w)
+                                           { return !isWordToken(w); }),
+                            url_words.end());
+            std::sort(url_words.begin(), url_words.end());
+            for (size_t i = 0; i < url_words.size();)
+            {
+                size_t j = i + 1;
+                while (j < url_words.size() && url_words[j] == url_words[i])
+                    j++;
+                addFieldPosting(shard.fields[field_url], getTermId(url_words[i]), id, static_cast<int>(j - i));
+                i = j;
             }
 
             return true;
         }
 
+        // 根据URL把文档加入所属库的位图
+        void addToLibrary(uint64_t id)
+        {
+            if (forward_index_.getUrlPrefix(id).empty())
+                return;
+            std::string name = libraryOfUrlPath(forward_index_.getUrlPath(id));
+            if (name.empty())
+                return;
+
+            auto ret = library_ids_.emplace(name, static_cast<uint32_t>(libraries_.size()));
+            if (ret.second)
+            {
+                libraries_.push_back(std::move(name));
+                library_docs_.emplace_back();
+            }
+            library_docs_[ret.first->second].add(static_cast<uint32_t>(id));
+        }
+
+        static void addFieldPosting(FieldPostings &field, uint32_t term_id, uint64_t id, int cnt)
+        {
+            if (term_id >= field.doc_ids.size())
+            {
+                field.doc_ids.resize(term_id + 1);
+                field.counts.resize(term_id + 1);
+            }
+            field.doc_ids[term_id].push_back(static_cast<uint32_t>(id));
+            field.counts[term_id].push_back(static_cast<uint16_t>(std::min(cnt, static_cast<int>(UINT16_MAX))));
+        }
+
     private:
-        std::vector<SelectedDocInfo> forward_index_;                                        // 正排索引结果
-        std::unordered_map<std::string, std::vector<BackwardIndexElement>> backward_index_; // 倒排索引结果
+        bs_forward_index::ForwardIndex forward_index_;                                      // 正排索引，按列存放
+        std::vector<IndexShard> shards_;                                                    // 倒排索引分片
+        bool positions_enabled_ = true;                                                     // 是否记录位置信息
+        bs_term_dictionary::TermDictionary dict_;                                           // 词典，所有分片共用
+        uint64_t dict_version_ = nextDictVersion();                                         // 词典版本
+        bs_suggest_index::SuggestIndex suggest_;                                            // 前缀补全索引
+        PruneOptions prune_;                                                                // 剪枝选项
+        std::unordered_set<std::string> stop_words_;                                        // 转为小写的停用词
+        std::vector<uint8_t> common_;                                                       // 下标为词编号，是否为高频词
+        std::vector<std::string> libraries_;                                                // 库名，下标为库编号
+        std::unordered_map<std::string, uint32_t> library_ids_;                             // 库名 -> 库编号
+        std::vector<bs_bitmap::RoaringBitmap> library_docs_;                                // 下标为库编号，属于该库的文档ID
+        std::unordered_map<std::string, uint32_t> pending_terms_;                           // 尚未合并进词典的新词 -> 词编号
         std::unordered_map<std::string, WordCount> word_cnt_;                               // 词频统计
-        static std::mutex mtx_;
-        cppjieba::Jieba jieba_;
+        uint64_t generation_ = 0;                                                           // 文本文件版本号
+        uint64_t raw_offset_ = 0;                                                           // 已经建立索引的文本文件长度
+        size_t deleted_cnt_ = 0;                                                            // 已删除的文档数
+        bs_tokenizer::Tokenizer tokenizer_;                                                 // 分词器，共用进程内的词典
     };
-
-    SearchIndex *SearchIndex::si = nullptr;
-    std::mutex SearchIndex::mtx_;
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,166 @@
+#ifndef __bs_suggest_index_h__
+#define __bs_suggest_index_h__
+
+#include <vector>
+#include <string_view>
+#include <algorithm>
+#include <cstdint>
+#include <cctype>
+#include <boost_search/search/term_dictionary.h>
+
+namespace bs_suggest_index
+{
+    /**
+     * 前缀补全索引，建立在词典之上，补全结果按照包含该词的文档数降序排列
+     * 1. 词典按照字典序编号，同一前缀的所有词编号连续，前缀查找得到一个编号区间
+     * 2. 区间较大的短前缀（用户输入前几个字符时）预先计算好前N个补全，查询时直接返回
+     * 3. 区间较小时直接扫描区间取前N个，扫描代价与预先计算的查表相当
+     */
+
+    // 每个前缀预先计算的补全数，也是默认返回的补全数
+    const size_t suggest_top_n = 10;
+    // 预先计算的最长前缀字节数（两个汉字）
+    const size_t max_precompute_prefix = 6;
+    // 区间内的词数不超过该值时直接扫描，不预先计算
+    const size_t scan_limit = 64;
+
+    class SuggestIndex
+    {
+        // 预先计算的前缀，以区间起始编号标识
+        struct PrefixEntry
+        {
+            uint32_t first;  // 前缀对应的第一个词编号
+            uint32_t offset; // 补全结果在top_的起始位置
+            uint32_t count;  // 补全结果数
+        };
+
+    public:
+        // df[i]为第i个词的文档频率，不包含字母、数字和非ASCII字符的词（标点、空白）不参与补全
+        void build(const bs_term_dictionary::TermDictionary &dict, std::vector<uint32_t> df)
+        {
+            uint32_t n = dict.size();
+            for (uint32_t i = 0; i < n; i++)
+            {
+                if (!isSuggestable(dict.getTerm(i)))
+                    df[i] = 0;
+            }
+            df_ = std::move(df);
+
+            top_.clear();
+            for (size_t len = 1; len <= max_precompute_prefix; len++)
+            {
+                auto &entries = levels_[len - 1];
+                entries.clear();
+
+                // 按照前len个字节对有序词表分组，每组是一个连续区间
+                uint32_t i = 0;
+                while (i < n)
+                {
+                    std::string_view term = dict.getTerm(i);
+                    if (term.size() < len)
+                    {
+                        i++;
+                        continue;
+                    }
+                    std::string_view prefix = term.substr(0, len);
+                    uint32_t j = i + 1;
+                    while (j < n && dict.getTerm(j).substr(0, len) == prefix)
+                        j++;
+
+                    if (j - i > scan_limit)
+                    {
+                        PrefixEntry e;
+                        e.first = i;
+                        e.offset = static_cast<uint32_t>(top_.size());
+                        topInRange(i, j, suggest_top_n, top_);
+                        e.count = static_cast<uint32_t>(top_.size() - e.offset);
+                        entries.push_back(e);
+                    }
+                    i = j;
+                }
+            }
+        }
+
+        // 获取以prefix开头的前n个词编号，按照文档频率降序排列，结果追加到out中
+        void suggest(const bs_term_dictionary::TermDictionary &dict, std::string_view prefix, size_t n, std::vector<uint32_t> &out) const
+        {
+            if (prefix.empty() || n == 0 || df_.size() != dict.size())
+                return;
+
+            auto range = dict.prefixRange(prefix);
+            if (range.first >= range.second)
+                return;
+
+            // 区间较大且前缀已经预先计算时直接查表
+            if (range.second - range.first > scan_limit && prefix.size() <= max_precompute_prefix && n <= suggest_top_n)
+            {
+                const auto &entries = levels_[prefix.size() - 1];
+                auto pos = std::lower_bound(entries.begin(), entries.end(), range.first, [](const PrefixEntry &e, uint32_t first)
+                                            { return e.first < first; });
+                if (pos != entries.end() && pos->first == range.first)
+                {
+                    size_t cnt = std::min<size_t>(n, pos->count);
+                    out.insert(out.end(), top_.begin() + pos->offset, top_.begin() + pos->offset + cnt);
+                    return;
+                }
+            }
+
+            topInRange(range.first, range.second, n, out);
+        }
+
+        // 获取词的文档频率
+        uint32_t getDocFreq(uint32_t term_id) const
+        {
+            return term_id < df_.size() ? df_[term_id] : 0;
+        }
+
+        // 占用的内存字节数
+        size_t memoryBytes() const
+        {
+            size_t bytes = df_.capacity() * sizeof(uint32_t) + top_.capacity() * sizeof(uint32_t);
+            for (const auto &entries : levels_)
+                bytes += entries.capacity() * sizeof(PrefixEntry);
+            return bytes;
+        }
+
+    private:
+        static bool isSuggestable(std::string_view term)
+        {
+            for (unsigned char c : term)
+            {
+                if (c >= 0x80 || std::isalnum(c))
+                    return true;
+            }
+            return false;
+        }
+
+        // 取编号区间[first, last)中文档频率最高的n个词，文档频率相同时按照字典序
+        void topInRange(uint32_t first, uint32_t last, size_t n, std::vector<uint32_t> &out) const
+        {
+            std::vector<uint32_t> ids;
+            ids.reserve(last - first);
+            for (uint32_t i = first; i < last; i++)
+            {
+                if (df_[i] > 0)
+                    ids.push_back(i);
+            }
+
+            auto cmp = [this](uint32_t a, uint32_t b)
+            {
+                if (df_[a] != df_[b])
+                    return df_[a] > df_[b];
+                return a < b;
+            };
+            size_t cnt = std::min(n, ids.size());
+            std::partial_sort(ids.begin(), ids.begin() + cnt, ids.end(), cmp);
+            out.insert(out.end(), ids.begin(), ids.begin() + cnt);
+        }
+
+    private:
+        std::vector<uint32_t> df_;                                // 每个词的文档频率
+        std::vector<uint32_t> top_;                               // 所有预先计算的补全结果
+        std::vector<PrefixEntry> levels_[max_precompute_prefix]; // 按前缀长度分组，每组按照起始编号有序
+    };
+}
+
+#endif
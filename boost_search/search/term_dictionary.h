@@ -0,0 +1,279 @@
+#ifndef __bs_term_dictionary_h__
+#define __bs_term_dictionary_h__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <cstring>
+
+namespace bs_term_dictionary
+{
+    /**
+     * 只读词典，建立完成后不再修改，用于替代倒排索引中的unordered_map<string, ...>
+     * 1. 所有词按字典序紧凑存放在一块连续内存中，词的编号就是它在字典序中的位置
+     * 2. 精确查找使用完美哈希（哈希+位移）：先按哈希分桶，每个桶记录一个位移值，使桶内的词映射到互不冲突的槽位
+     *    查找时只需要计算一次哈希、读取一次位移和一次槽位，再与词表比较一次确认
+     * 3. 前缀查找在有序词表上二分，返回编号连续的区间
+     * 4. 所有数据都是定长数组，可以直接序列化到索引文件中
+     */
+
+    // 不存在的词
+    const uint32_t npos = UINT32_MAX;
+    // 平均每个桶中的词数
+    const size_t keys_per_bucket = 4;
+    // 槽位数与词数之比的倒数，槽位越多构建越快
+    const double slot_load_factor = 0.9;
+    // 序列化格式标识
+    const uint32_t dictionary_magic = 0x54444943; // "TDIC"
+
+    // 64位字符串哈希，每次处理8字节
+    inline uint64_t hashTerm(std::string_view s, uint64_t seed = 0)
+    {
+        const uint64_t m = 0x9E3779B97F4A7C15ULL;
+        uint64_t h = seed ^ (s.size() * m);
+        const char *p = s.data();
+        size_t n = s.size();
+        while (n >= 8)
+        {
+            uint64_t v;
+            std::memcpy(&v, p, 8);
+            h = (h ^ v) * m;
+            h ^= h >> 29;
+            p += 8;
+            n -= 8;
+        }
+        if (n > 0)
+        {
+            uint64_t v = 0;
+            std::memcpy(&v, p, n);
+            h = (h ^ v) * m;
+        }
+        h ^= h >> 32;
+        h *= 0xD6E8FEB86659FD93ULL;
+        h ^= h >> 32;
+        return h;
+    }
+
+    // 将32位哈希值均匀映射到[0, n)，避免取模运算
+    inline uint32_t fastRange(uint32_t h, uint32_t n)
+    {
+        return static_cast<uint32_t>((static_cast<uint64_t>(h) * n) >> 32);
+    }
+
+    // 将位移值打散，使不同位移得到差异较大的槽位
+    inline uint64_t mixPilot(uint64_t pilot)
+    {
+        pilot *= 0xC6A4A7935BD1E995ULL;
+        pilot ^= pilot >> 47;
+        return pilot * 0xC6A4A7935BD1E995ULL;
+    }
+
+    class TermDictionary
+    {
+    public:
+        TermDictionary()
+        {
+            offsets_.push_back(0);
+        }
+
+        // 使用已经排好序且没有重复的词建立词典
+        void build(const std::vector<std::string_view> &sorted_terms)
+        {
+            arena_.clear();
+            offsets_.assign(1, 0);
+            size_t total = 0;
+            for (auto t : sorted_terms)
+                total += t.size();
+            arena_.reserve(total);
+            offsets_.reserve(sorted_terms.size() + 1);
+            for (auto t : sorted_terms)
+            {
+                arena_.append(t.data(), t.size());
+                offsets_.push_back(static_cast<uint32_t>(arena_.size()));
+            }
+
+            buildPerfectHash();
+        }
+
+        // 精确查找，返回词的编号，不存在时返回npos
+        uint32_t find(std::string_view term) const
+        {
+            if (slots_.empty())
+                return npos;
+            uint64_t h = hashTerm(term);
+            uint32_t bucket = fastRange(static_cast<uint32_t>(h >> 32), static_cast<uint32_t>(pilots_.size()));
+            uint32_t slot = getSlot(h, pilots_[bucket]);
+            uint32_t id = slots_[slot];
+            if (id == npos || getTerm(id) != term)
+                return npos;
+            return id;
+        }
+
+        // 前缀查找，返回编号区间[first, second)，没有匹配时区间为空
+        std::pair<uint32_t, uint32_t> prefixRange(std::string_view prefix) const
+        {
+            uint32_t first = lowerBound(prefix);
+            // 以prefix开头的词在有序词表中连续，再二分出第一个不以prefix开头的词
+            uint32_t lo = first, hi = size();
+            while (lo < hi)
+            {
+                uint32_t mid = lo + (hi - lo) / 2;
+                if (getTerm(mid).substr(0, prefix.size()) == prefix)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            return {first, lo};
+        }
+
+        // 根据编号获取词
+        std::string_view getTerm(uint32_t id) const
+        {
+            return std::string_view(arena_.data() + offsets_[id], offsets_[id + 1] - offsets_[id]);
+        }
+
+        uint32_t size() const
+        {
+            return static_cast<uint32_t>(offsets_.size() - 1);
+        }
+
+        // 占用的内存字节数
+        size_t memoryBytes() const
+        {
+            return arena_.capacity() + offsets_.capacity() * sizeof(uint32_t) + pilots_.capacity() * sizeof(uint32_t) + slots_.capacity() * sizeof(uint32_t);
+        }
+
+        // 序列化为连续的二进制数据，追加到out中
+        // 格式：标识、词数、位移数、槽位数、词表长度，之后依次为各个数组
+        void serialize(std::string &out) const
+        {
+            auto put = [&](const void *p, size_t len)
+            { out.append(static_cast<const char *>(p), len); };
+            uint32_t header[5] = {dictionary_magic, size(), static_cast<uint32_t>(pilots_.size()), static_cast<uint32_t>(slots_.size()), static_cast<uint32_t>(arena_.size())};
+            put(header, sizeof(header));
+            put(offsets_.data(), offsets_.size() * sizeof(uint32_t));
+            put(pilots_.data(), pilots_.size() * sizeof(uint32_t));
+            put(slots_.data(), slots_.size() * sizeof(uint32_t));
+            put(arena_.data(), arena_.size());
+        }
+
+        // 从序列化数据中恢复，返回读取的字节数，格式错误时返回0
+        size_t deserialize(std::string_view in)
+        {
+            uint32_t header[5];
+            if (in.size() < sizeof(header))
+                return 0;
+            std::memcpy(header, in.data(), sizeof(header));
+            if (header[0] != dictionary_magic)
+                return 0;
+
+            size_t need = sizeof(header) + (static_cast<size_t>(header[1]) + 1 + header[2] + header[3]) * sizeof(uint32_t) + header[4];
+            if (in.size() < need)
+                return 0;
+
+            const char *p = in.data() + sizeof(header);
+            auto get = [&](auto &vec, size_t cnt)
+            {
+                vec.resize(cnt);
+                std::memcpy(vec.data(), p, cnt * sizeof(vec[0]));
+                p += cnt * sizeof(vec[0]);
+            };
+            get(offsets_, header[1] + 1);
+            get(pilots_, header[2]);
+            get(slots_, header[3]);
+            arena_.assign(p, header[4]);
+            return need;
+        }
+
+    private:
+        uint32_t getSlot(uint64_t h, uint32_t pilot) const
+        {
+            return fastRange(static_cast<uint32_t>(h ^ mixPilot(pilot)), static_cast<uint32_t>(slots_.size()));
+        }
+
+        // 有序词表上的二分查找，返回第一个不小于key的编号
+        uint32_t lowerBound(std::string_view key) const
+        {
+            uint32_t lo = 0, hi = size();
+            while (lo < hi)
+            {
+                uint32_t mid = lo + (hi - lo) / 2;
+                if (getTerm(mid) < key)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            return lo;
+        }
+
+        // 按桶从大到小依次寻找位移值，使桶内所有词落在空闲且互不相同的槽位上
+        void buildPerfectHash()
+        {
+            uint32_t n = size();
+            pilots_.clear();
+            slots_.clear();
+            if (n == 0)
+                return;
+
+            uint32_t bucket_num = static_cast<uint32_t>((n + keys_per_bucket - 1) / keys_per_bucket);
+            uint32_t slot_num = static_cast<uint32_t>(n / slot_load_factor) + 1;
+            pilots_.assign(bucket_num, 0);
+            slots_.assign(slot_num, npos);
+
+            std::vector<uint64_t> hashes(n);
+            std::vector<std::vector<uint32_t>> buckets(bucket_num);
+            for (uint32_t i = 0; i < n; i++)
+            {
+                hashes[i] = hashTerm(getTerm(i));
+                buckets[fastRange(static_cast<uint32_t>(hashes[i] >> 32), bucket_num)].push_back(i);
+            }
+
+            std::vector<uint32_t> order(bucket_num);
+            for (uint32_t i = 0; i < bucket_num; i++)
+                order[i] = i;
+            std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+                             { return buckets[a].size() > buckets[b].size(); });
+
+            std::vector<uint32_t> taken;
+            for (uint32_t b : order)
+            {
+                const auto &keys = buckets[b];
+                if (keys.empty())
+                    break;
+                for (uint32_t pilot = 0;; pilot++)
+                {
+                    taken.clear();
+                    bool ok = true;
+                    for (uint32_t k : keys)
+                    {
+                        uint32_t slot = getSlot(hashes[k], pilot);
+                        if (slots_[slot] != npos || std::find(taken.begin(), taken.end(), slot) != taken.end())
+                        {
+                            ok = false;
+                            break;
+                        }
+                        taken.push_back(slot);
+                    }
+                    if (!ok)
+                        continue;
+
+                    pilots_[b] = pilot;
+                    for (size_t i = 0; i < keys.size(); i++)
+                        slots_[taken[i]] = keys[i];
+                    break;
+                }
+            }
+        }
+
+    private:
+        std::string arena_;             // 按字典序紧凑存放的所有词
+        std::vector<uint32_t> offsets_; // 第i个词在arena_中的起始位置，最后一个元素为总长度
+        std::vector<uint32_t> pilots_;  // 每个桶的位移值
+        std::vector<uint32_t> slots_;   // 槽位对应的词编号，空槽位为npos
+    };
+}
+
+#endif
@@ -0,0 +1,212 @@
+#ifndef __bs_tokenizer_h__
+#define __bs_tokenizer_h__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include <boost_search/include/cppjieba/Jieba.hpp> // 引入Jieba分词
+
+namespace bs_tokenizer
+{
+    // ASCII空白，Jieba按照空白切分句子，空白本身作为单独的词输出
+    inline bool isAsciiSpace(unsigned char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    inline bool isAsciiDigit(unsigned char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    inline bool isAsciiLetter(unsigned char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    // 把ASCII大写字母转为小写，非ASCII字节保持不变，与在C语言区域下调用boost::to_lower的结果相同
+    inline void asciiToLower(char *data, size_t size)
+    {
+        size_t i = 0;
+#if defined(__SSE2__)
+        // 有符号比较，非ASCII字节为负数，不会落在['A', 'Z']中
+        const __m128i before_a = _mm_set1_epi8('A' - 1);
+        const __m128i after_z = _mm_set1_epi8('Z' + 1);
+        const __m128i flip = _mm_set1_epi8(0x20);
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, before_a), _mm_cmplt_epi8(v, after_z));
+            v = _mm_or_si128(v, _mm_and_si128(upper, flip));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(data + i), v);
+        }
+#endif
+        for (; i < size; i++)
+        {
+            if (data[i] >= 'A' && data[i] <= 'Z')
+                data[i] = static_cast<char>(data[i] | 0x20);
+        }
+    }
+
+    // 从pos开始找到下一个ASCII空白的位置，同时记录经过的部分是否包含非ASCII字节
+    inline size_t findChunkEnd(const char *data, size_t pos, size_t size, bool &has_non_ascii)
+    {
+#if defined(__SSE2__)
+        // 每次检查16个字节：最高位为1的是非ASCII字节，空格和'\t'~'\r'是空白
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i before_tab = _mm_set1_epi8('\t' - 1);
+        const __m128i after_cr = _mm_set1_epi8('\r' + 1);
+        while (pos + 16 <= size)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+            int high = _mm_movemask_epi8(v);
+            __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(v, space),
+                                         _mm_and_si128(_mm_cmpgt_epi8(v, before_tab), _mm_cmplt_epi8(v, after_cr)));
+            int blank_mask = _mm_movemask_epi8(blank);
+            if (blank_mask)
+            {
+                int k = __builtin_ctz(blank_mask);
+                has_non_ascii |= (high & ((1 << k) - 1)) != 0;
+                return pos + k;
+            }
+            has_non_ascii |= high != 0;
+            pos += 16;
+        }
+#endif
+        for (; pos < size; pos++)
+        {
+            unsigned char c = data[pos];
+            if (c >= 0x80)
+                has_non_ascii = true;
+            else if (isAsciiSpace(c))
+                break;
+        }
+        return pos;
+    }
+
+    /**
+     * 分词器句柄，所有句柄共用进程内唯一的Jieba实例
+     * 1. 词典、HMM模型和前缀树只在第一次使用时加载一次，SearchIndex、SearchEngine以及每次重新加载建立的新索引都不再重复加载
+     * 2. Jieba的分词接口是只读的，多个线程可以同时通过各自的句柄分词
+     * 3. 句柄只保存一个引用，可以按值传递，也可以在每个线程中各自创建
+     * 文档几乎都是英文和C++标识符，输入先按照ASCII空白切分成片段，与Jieba切分句子的方式相同：
+     * 只包含ASCII字符的片段直接按照Jieba的HMM规则切分（字母开头的字母数字串、数字开头的数字和小数点串、其余字符各自成词），
+     * 包含非ASCII字符的片段才交给Jieba。输出的词都已经转为小写
+     */
+    class Tokenizer
+    {
+    public:
+        Tokenizer()
+            : jieba_(sharedJieba())
+        {
+        }
+
+        // 搜索引擎模式分词，结果追加到words中
+        void cutForSearch(std::string_view text, std::vector<std::string> &words) const
+        {
+            cut(text, [&words](const char *data, size_t size, size_t)
+                { words.emplace_back(data, size); },
+                [this, &words](const std::string &chunk, size_t)
+                {
+                    size_t first = words.size();
+                    jieba_.CutForSearch(chunk, words);
+                    for (size_t i = first; i < words.size(); i++)
+                        asciiToLower(&words[i][0], words[i].size());
+                });
+        }
+
+        // 搜索引擎模式分词，同时得到每个词在text中的字节偏移，结果追加到words中
+        void cutForSearch(std::string_view text, std::vector<cppjieba::Word> &words) const
+        {
+            cut(text, [&words](const char *data, size_t size, size_t offset)
+                { words.emplace_back(std::string(data, size), static_cast<uint32_t>(offset)); },
+                [this, &words](const std::string &chunk, size_t offset)
+                {
+                    size_t first = words.size();
+                    jieba_.CutForSearch(chunk, words);
+                    for (size_t i = first; i < words.size(); i++)
+                    {
+                        asciiToLower(&words[i].word[0], words[i].word.size());
+                        words[i].offset += static_cast<uint32_t>(offset);
+                    }
+                });
+        }
+
+    private:
+        // emit(data, size, offset)输出一个ASCII词，cut_chunk(chunk, offset)用Jieba切分一个包含非ASCII字符的片段
+        template <class Emit, class CutChunk>
+        static void cut(std::string_view text, Emit &&emit, CutChunk &&cut_chunk)
+        {
+            // 转为小写的ASCII片段，线程内复用
+            thread_local std::string lower;
+
+            const char *data = text.data();
+            size_t size = text.size();
+            size_t pos = 0;
+            while (pos < size)
+            {
+                if (isAsciiSpace(data[pos]))
+                {
+                    emit(data + pos, 1, pos);
+                    pos++;
+                    continue;
+                }
+
+                bool has_non_ascii = false;
+                size_t end = findChunkEnd(data, pos, size, has_non_ascii);
+                if (has_non_ascii)
+                {
+                    cut_chunk(std::string(text.substr(pos, end - pos)), pos);
+                    pos = end;
+                    continue;
+                }
+
+                lower.assign(data + pos, end - pos);
+                asciiToLower(&lower[0], lower.size());
+                cutAscii(lower.data(), lower.size(), pos, emit);
+                pos = end;
+            }
+        }
+
+        // 按照Jieba的HMM规则切分不含空白的ASCII片段，data已经转为小写，base为片段在原文中的偏移
+        template <class Emit>
+        static void cutAscii(const char *data, size_t size, size_t base, Emit &emit)
+        {
+            size_t i = 0;
+            while (i < size)
+            {
+                unsigned char c = data[i];
+                size_t j = i + 1;
+                if (isAsciiLetter(c))
+                {
+                    while (j < size && (isAsciiLetter(data[j]) || isAsciiDigit(data[j])))
+                        j++;
+                }
+                else if (isAsciiDigit(c))
+                {
+                    while (j < size && (isAsciiDigit(data[j]) || data[j] == '.'))
+                        j++;
+                }
+                emit(data + i, j - i, base + i);
+                i = j;
+            }
+        }
+
+        // 第一次调用时加载词典，C++11保证局部静态变量的初始化是线程安全的
+        static const cppjieba::Jieba &sharedJieba()
+        {
+            static const cppjieba::Jieba jieba;
+            return jieba;
+        }
+
+    private:
+        const cppjieba::Jieba &jieba_;
+    };
+}
+
+#endif
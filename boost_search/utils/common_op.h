@@ -14,8 +14,9 @@ namespace bs_common_op
     {
     public:
         // 字符串分割
-        // 使用string_view自主实现split
-        static size_t split(std::vector<std::string> &out, std::string_view line, std::string_view sep)
+        // 使用string_view自主实现split，out的元素为std::string_view时不复制子串，结果引用line
+        template <class String>
+        static size_t split(std::vector<String> &out, std::string_view line, std::string_view sep)
         {
             if (line.empty())
                 return 0;
@@ -33,14 +34,14 @@ namespace bs_common_op
                     continue;
                 }
                 // 添加当前位置到分隔符之间的子字符串
-                out.push_back(std::string(single));
+                out.emplace_back(single);
                 // 更新位置到分隔符之后
                 pos = found + sep.length();
             }
 
             // 添加最后一个分隔符之后的子字符串
             if (pos < line.length())
-                out.push_back(std::string(line.substr(pos)));
+                out.emplace_back(line.substr(pos));
 
             return out.size();
         }
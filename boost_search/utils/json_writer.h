@@ -0,0 +1,204 @@
+#ifndef __rs_json_writer_h__
+#define __rs_json_writer_h__
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace bs_json_writer
+{
+    // 从pos开始找到下一个需要转义的字节：双引号、反斜杠和小于0x20的控制字符
+    inline size_t findEscape(const char *data, size_t pos, size_t size)
+    {
+#if defined(__SSE2__)
+        // 每次检查16个字节，无符号比较v <= 0x1F通过min(v, 0x1F) == v判断
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i control = _mm_set1_epi8(0x1F);
+        while (pos + 16 <= size)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+            __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+                                       _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+            int mask = _mm_movemask_epi8(hit);
+            if (mask)
+                return pos + __builtin_ctz(mask);
+            pos += 16;
+        }
+#endif
+        for (; pos < size; pos++)
+        {
+            unsigned char c = data[pos];
+            if (c == '"' || c == '\\' || c < 0x20)
+                break;
+        }
+        return pos;
+    }
+
+    // 将s按照JSON字符串的规则转义后追加到out中，不包括两侧的引号
+    // 非ASCII字节原样输出，调用者保证s是完整的UTF-8序列
+    inline void appendEscaped(std::string &out, std::string_view s)
+    {
+        static const char hex[] = "0123456789abcdef";
+        const char *data = s.data();
+        size_t size = s.size();
+        size_t plain = 0;
+        while (plain < size)
+        {
+            // 不需要转义的连续字节整段复制
+            size_t pos = findEscape(data, plain, size);
+            out.append(data + plain, pos - plain);
+            if (pos == size)
+                break;
+
+            unsigned char c = data[pos];
+            switch (c)
+            {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\b':
+                out += "\\b";
+                break;
+            case '\f':
+                out += "\\f";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xF];
+                break;
+            }
+            plain = pos + 1;
+        }
+    }
+
+    /**
+     * 流式JSON生成器，直接把数组、对象和值追加到调用者的字符串中，不构造中间的DOM
+     * 1. 由调用者保证begin和end成对出现、对象中key和value交替出现，生成器只负责逗号和转义
+     * 2. 字符串值可以由两段拼接而成（例如URL的前缀和相对路径），不需要先拼接出临时字符串
+     * 用法：
+     *     JsonWriter writer(out);
+     *     writer.beginArray();
+     *     writer.beginObject();
+     *     writer.key("title");
+     *     writer.value(title);
+     *     writer.endObject();
+     *     writer.endArray();
+     */
+    class JsonWriter
+    {
+    public:
+        explicit JsonWriter(std::string &out)
+            : out_(out), first_(true)
+        {
+        }
+
+        void beginArray()
+        {
+            separate();
+            out_ += '[';
+            first_ = true;
+        }
+
+        void endArray()
+        {
+            out_ += ']';
+            first_ = false;
+        }
+
+        void beginObject()
+        {
+            separate();
+            out_ += '{';
+            first_ = true;
+        }
+
+        void endObject()
+        {
+            out_ += '}';
+            first_ = false;
+        }
+
+        // 对象的键，之后必须紧跟一个值
+        void key(std::string_view name)
+        {
+            separate();
+            appendQuoted(name);
+            out_ += ':';
+            first_ = true;
+        }
+
+        void value(std::string_view s)
+        {
+            separate();
+            appendQuoted(s);
+        }
+
+        // 由prefix和s两段拼接而成的字符串
+        void value(std::string_view prefix, std::string_view s)
+        {
+            separate();
+            out_ += '"';
+            appendEscaped(out_, prefix);
+            appendEscaped(out_, s);
+            out_ += '"';
+        }
+
+        void value(const char *s)
+        {
+            value(std::string_view(s));
+        }
+
+        void value(uint64_t n)
+        {
+            separate();
+            char buf[20];
+            char *p = buf + sizeof(buf);
+            do
+            {
+                *--p = static_cast<char>('0' + n % 10);
+                n /= 10;
+            } while (n > 0);
+            out_.append(p, buf + sizeof(buf) - p);
+        }
+
+    private:
+        // 同一层中第一个元素之前不需要逗号
+        void separate()
+        {
+            if (!first_)
+                out_ += ',';
+            first_ = false;
+        }
+
+        void appendQuoted(std::string_view s)
+        {
+            out_ += '"';
+            appendEscaped(out_, s);
+            out_ += '"';
+        }
+
+    private:
+        std::string &out_;
+        bool first_; // 当前层还没有输出任何元素，或者刚输出了键
+    };
+}
+
+#endif